@@ -10,8 +10,33 @@
 #ifndef CX_ENDIAN_HPP
 #define CX_ENDIAN_HPP
 
+// Conversions of single values are constexpr, and inline; one to the
+// host's own order is nothing at all, and one to the other order is
+// a single byte-swapping instruction (where the host has one.)
+
+#include <stddef.h>
+#include <string.h>
+#include <atomic>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+
+#if __has_include(<bit>)
+#include <bit>
+#endif
+
+#include "cx-types.hpp"
 #include "cx-hackery.hpp"
 
+// where the x86 kernels are built; CX_TARGET() builds each for its
+// own instructions, so that the rest of the library (and its callers)
+// needn't be built for them
+#if (defined(__x86_64__) || defined(__i386__)) && \
+    (defined(__GNUC__) || defined(__clang__))
+  #define CX_ENDIAN_X86 1
+  #define CX_TARGET(isa) __attribute__((target(isa)))
+#endif
+
 namespace CX {
 namespace Endian {
 
@@ -19,54 +44,355 @@ namespace Endian {
   // 1. MinGW32's header files don't provide ntohll()
   // 2. The various OSes we support cannot agree on which header
   //    file they belong in.
+  // 3. None of them are constexpr.
   // So, we roll our own instead.
   //////////#include <netinet/in.h>   /* some *nix */
   //////////#include <arpa/inet.h>    /* some *nix */
   //////////#include <winsock2.h>     /* windows */
 
-  namespace detail
+  enum class Order
   {
-    template <typename T> T bswap(T value); // explicit specializations
-
-    template<> U16 bswap<U16>(U16 value);
-    template<> S16 bswap<S16>(S16 value);
-    template<> U32 bswap<U32>(U32 value);
-    template<> S32 bswap<S32>(S32 value);
-    template<> U64 bswap<U64>(U64 value);
-    template<> S64 bswap<S64>(S64 value);
+    LITTLE,
+    BIG,
   };
 
-  template <typename T> T betoh(T value)
+#if defined(__cpp_lib_endian)
+  constexpr Order HOST = (std::endian::native == std::endian::big) ?
+                           Order::BIG : Order::LITTLE;
+#elif defined(__BYTE_ORDER__)
+  constexpr Order HOST = (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__) ?
+                           Order::BIG : Order::LITTLE;
+#else
+  #error "Unable to tell the host's byte order"
+#endif
+
+  namespace detail
   {
-    if (CX_HOST_IS_BIG_ENDIAN)
-      return value;
+    template <typename T>
+    constexpr T bswap(T value)
+    {
+      static_assert(std::is_integral<T>::value,
+                    "only integers have a byte order");
+      typedef std::make_unsigned_t<T> U;
+
+      if constexpr (sizeof(T) == 1)
+        return value;
+#if defined(__GNUC__) || defined(__clang__)
+      else if constexpr (sizeof(T) == 2)
+        return static_cast<T>(__builtin_bswap16(static_cast<U>(value)));
+      else if constexpr (sizeof(T) == 4)
+        return static_cast<T>(__builtin_bswap32(static_cast<U>(value)));
+      else
+        return static_cast<T>(__builtin_bswap64(static_cast<U>(value)));
+#else
+      else if constexpr (sizeof(T) == 2)
+        return static_cast<T>(CX_BSWAP16(static_cast<U>(value)));
+      else if constexpr (sizeof(T) == 4)
+        return static_cast<T>(CX_BSWAP32(static_cast<U>(value)));
+      else
+        return static_cast<T>(CX_BSWAP64(static_cast<U>(value)));
+#endif
+    }
 
-      return detail::bswap(value);
+    template <typename T>
+    using Integer = std::enable_if_t<std::is_integral<T>::value, T>;
+
+    // between the host's order and 'ORDER'; it's the same either way
+    template <Order ORDER, typename T>
+    constexpr T convert(T value)
+    {
+      if constexpr (ORDER == HOST)
+        return value;
+      else
+        return bswap(value);
+    }
   }
 
-  template <typename T> T letoh(T value)
+  // (these are only for integers, so that the array overloads below
+  // aren't ambiguous with them)
+  template <typename T> constexpr detail::Integer<T> betoh(T value)
   {
-    if (CX_HOST_IS_LITTLE_ENDIAN)
-      return value;
+    return detail::convert<Order::BIG>(value);
+  }
 
-    return detail::bswap(value);
+  template <typename T> constexpr detail::Integer<T> letoh(T value)
+  {
+    return detail::convert<Order::LITTLE>(value);
   }
 
 
-  template <typename T> T htobe(T value)
+  template <typename T> constexpr detail::Integer<T> htobe(T value)
   {
     return betoh(value);
   }
 
 
-  template <typename T> T htole(T value)
+  template <typename T> constexpr detail::Integer<T> htole(T value)
   {
     return letoh(value);
   }
 
+
+  // Whole arrays at once, with SIMD where the CPU has it (see
+  // src/cx-endian.cpp.)  'out' and 'in' may be the same array, to
+  // convert in place, but mustn't otherwise overlap; neither needs
+  // to be aligned, even to its elements.
+
+  // the SIMD kernels, in order of preference
+  enum class Kernel: U8
+  {
+    SCALAR,
+    SSSE3,
+    AVX2,
+    AVX512,
+  };
+
+  // the best the CPU has, unless set otherwise
+  Kernel get_kernel();
+
+  // false (and no change) when the CPU lacks 'kernel'
+  bool set_kernel(Kernel kernel);
+  char const* kernel_name(Kernel kernel);
+
+  // whether the CPU has 'kernel' (and this build, its instructions)
+  bool supported(Kernel kernel);
+
+
+  // the kernel in use, for a component with kernels of its own (as
+  // in cx-varint.cpp): of its 'TKernels' (each with a 'kernel', and
+  // listed in order of preference), the best supported() one, chosen
+  // on first use; unless Select() chose first.
+  template <typename TKernels, size_t SIZE>
+  class KernelTable
+  {
+  public:
+    constexpr KernelTable(TKernels const (&all)[SIZE])
+      : all_(all), active_(nullptr)
+    {
+    }
+
+    TKernels const& Active()
+    {
+      TKernels const* active = active_.load(std::memory_order_acquire);
+      if (CX_UNLIKELY(!active))
+      {
+        // unless Select() got there first
+        TKernels const* best = &all_[0];
+        for (auto const& kernels : all_)
+          if (supported(kernels.kernel))
+            best = &kernels;
+        if (active_.compare_exchange_strong(active, best,
+                                            std::memory_order_acq_rel))
+          active = best;
+      }
+      return *active;
+    }
+
+    // false (and no change) when 'kernel' isn't had, or supported()
+    bool Select(Kernel kernel)
+    {
+      for (auto const& kernels : all_)
+      {
+        if ((kernels.kernel == kernel) && supported(kernel))
+        {
+          active_.store(&kernels, std::memory_order_release);
+          return true;
+        }
+      }
+      return false;
+    }
+
+  private:
+    TKernels const (&all_)[SIZE];
+    std::atomic<TKernels const*> active_;
+  };
+
+  namespace detail
+  {
+    void bswap16(void* out, void const* in, size_t count);
+    void bswap32(void* out, void const* in, size_t count);
+    void bswap64(void* out, void const* in, size_t count);
+
+    template <Order ORDER, typename T>
+    void convert(T* out, T const* in, size_t count)
+    {
+      static_assert(std::is_integral<T>::value,
+                    "only integers have a byte order");
+
+      if constexpr ((ORDER == HOST) || (sizeof(T) == 1))
+      {
+        if (out != in)
+          memmove(out, in, count * sizeof(T));
+      }
+      else if constexpr (sizeof(T) == 2)
+        bswap16(out, in, count);
+      else if constexpr (sizeof(T) == 4)
+        bswap32(out, in, count);
+      else
+        bswap64(out, in, count);
+    }
+
+    // of anything with data() and size(), and of C arrays
+    template <typename TArray>
+    using Array = decltype(std::data(std::declval<TArray&>()),
+                           std::size(std::declval<TArray&>()), void());
+  }
+
+  template <typename T>
+  void betoh(T* out, T const* in, size_t count)
+  {
+    detail::convert<Order::BIG>(out, in, count);
+  }
+
+  template <typename T>
+  void letoh(T* out, T const* in, size_t count)
+  {
+    detail::convert<Order::LITTLE>(out, in, count);
+  }
+
+  template <typename T>
+  void htobe(T* out, T const* in, size_t count)
+  {
+    betoh(out, in, count);
+  }
+
+  template <typename T>
+  void htole(T* out, T const* in, size_t count)
+  {
+    letoh(out, in, count);
+  }
+
+  // in place
+  template <typename T>
+  void betoh(T* values, size_t count)   { betoh(values, values, count); }
+  template <typename T>
+  void letoh(T* values, size_t count)   { letoh(values, values, count); }
+  template <typename T>
+  void htobe(T* values, size_t count)   { betoh(values, values, count); }
+  template <typename T>
+  void htole(T* values, size_t count)   { letoh(values, values, count); }
+
+  // in place, for vectors, std::arrays, C arrays and the like
+  template <typename TArray, typename = detail::Array<TArray>>
+  void betoh(TArray& values)
+  {
+    betoh(std::data(values), std::size(values));
+  }
+
+  template <typename TArray, typename = detail::Array<TArray>>
+  void letoh(TArray& values)
+  {
+    letoh(std::data(values), std::size(values));
+  }
+
+  template <typename TArray, typename = detail::Array<TArray>>
+  void htobe(TArray& values)
+  {
+    betoh(std::data(values), std::size(values));
+  }
+
+  template <typename TArray, typename = detail::Array<TArray>>
+  void htole(TArray& values)
+  {
+    letoh(std::data(values), std::size(values));
+  }
+
+
+  // an integer kept in 'ORDER', whatever the host's; converted as it
+  // is read or written.  it is kept as bytes, so it may sit anywhere
+  // (it's never padded, nor misaligned), as in on-disk and wire
+  // structs.  being trivial, such structs can be memcpy()d, or read
+  // from a file, as they are.
+  template <typename T, Order ORDER>
+  class Ordered
+  {
+    static_assert(std::is_integral<T>::value,
+                  "only integers have a byte order");
+    typedef std::make_unsigned_t<T> U;
+
+  public:
+    Ordered() = default;
+
+    constexpr Ordered(T value) : bytes_{}
+    {
+      Set(value);
+    }
+
+    constexpr T Get() const
+    {
+#if defined(__GNUC__) || defined(__clang__)
+      // at runtime, an (unaligned) load and perhaps a byte-swap
+      if (!__builtin_is_constant_evaluated())
+      {
+        U value = 0;
+        __builtin_memcpy(&value, bytes_, sizeof(T));
+        return static_cast<T>(detail::convert<ORDER>(value));
+      }
+#endif
+      return static_cast<T>(load());
+    }
+
+    constexpr void Set(T value)
+    {
+#if defined(__GNUC__) || defined(__clang__)
+      if (!__builtin_is_constant_evaluated())
+      {
+        U stored = detail::convert<ORDER>(static_cast<U>(value));
+        __builtin_memcpy(bytes_, &stored, sizeof(T));
+        return;
+      }
+#endif
+      store(static_cast<U>(value));
+    }
+
+    constexpr operator T() const
+    {
+      return Get();
+    }
+
+    constexpr Ordered& operator=(T value)
+    {
+      Set(value);
+      return *this;
+    }
+
+    // as they are kept
+    constexpr U8 const* Bytes() const
+    {
+      return bytes_;
+    }
+
+  private:
+    // of byte 'i', within the value
+    static constexpr unsigned shift(size_t i)
+    {
+      return 8 * static_cast<unsigned>((ORDER == Order::BIG) ?
+                                         (sizeof(T) - 1 - i) : i);
+    }
+
+    // a byte at a time, as constant expressions must
+    constexpr U load() const
+    {
+      U value = 0;
+      for (size_t i = 0; i < sizeof(T); ++i)
+        value |= static_cast<U>(static_cast<U>(bytes_[i]) << shift(i));
+      return value;
+    }
+
+    constexpr void store(U value)
+    {
+      for (size_t i = 0; i < sizeof(T); ++i)
+        bytes_[i] = static_cast<U8>(value >> shift(i));
+    }
+
+    U8 bytes_[sizeof(T)];
+  };
+
+  template <typename T> using be = Ordered<T, Order::BIG>;
+  template <typename T> using le = Ordered<T, Order::LITTLE>;
+
 } // namespace 'Endian'
 } // namespace 'CX'
 
 
 #endif // CX_ENDIAN_HPP
-
@@ -0,0 +1,374 @@
+// vim: set tabstop=2 softtabstop=2 shiftwidth=2 expandtab :
+/*
+ * Copyright (c) 2026, Ryan V. Bissell
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ * See the enclosed "LICENSE" file for exact license terms.
+ */
+
+#ifndef CX_ENDIANIO_HPP
+#define CX_ENDIANIO_HPP
+
+// Reading and writing binary formats, in place, over someone else's
+// bytes (such as a MappedFile's).
+//
+// Every read or write is bounds-checked, and throws a BytesException
+// (BytesError::BOUNDS) rather than overrun.  To pay for one check per
+// record rather than one per field, either
+//
+//   Header header = reader.Read<Header>();
+//
+// where Header is a struct of CX::Endian::be<> and le<> fields (so,
+// unpadded, and converted as they're used); or
+//
+//   auto record = reader.Take<16>();
+//   U32 magic = record.BE<U32, 0>();
+//   U16 version = record.LE<U16, 4>();
+//
+// whose fields are checked as it's compiled.  Strings and blobs are
+// returned as views of the bytes themselves, never copied.
+
+#include <string.h>
+
+#include <string_view>
+#include <type_traits>
+
+#include "cx-types.hpp"
+#include "cx-hackery.hpp"
+#include "cx-tracedebug.hpp"
+#include "cx-exceptions.hpp"
+#include "cx-result.hpp"
+#include "cx-endian.hpp"
+
+namespace CX
+{
+  #define CX_BYTES_EXCEPTIONS                                         \
+    X(BOUNDS,     "Beyond the end of the bytes.")                    \
+    X(MAP,        "Unable to map the file.")
+
+  #define X(v,str) v,
+  enum class BytesError: U32
+  {
+    CX_BYTES_EXCEPTIONS
+  };
+  #undef X
+
+  #define X(v,str) { BytesError::v, "CXBytesError::" #v, str },
+  CX_DECLARE_EXCEPTION_CODES(BytesError, CX_BYTES_EXCEPTIONS);
+  #undef X
+
+  CX_DECLARE_BASE_EXCEPTION_CLASS(BytesException, BytesError);
+
+
+  // bytes that someone else owns
+  class ByteSpan
+  {
+  public:
+    constexpr ByteSpan() = default;
+
+    constexpr ByteSpan(void const* data, size_t size)
+      : data_(static_cast<U8 const*>(data)), size_(size)
+    {
+    }
+
+    constexpr U8 const* data() const  { return data_; }
+    constexpr size_t size() const     { return size_; }
+    constexpr bool empty() const      { return size_ == 0; }
+
+    constexpr U8 const* begin() const { return data_; }
+    constexpr U8 const* end() const   { return data_ + size_; }
+
+    // the same bytes, as text
+    std::string_view View() const
+    {
+      return { reinterpret_cast<char const*>(data_), size_ };
+    }
+
+  private:
+    U8 const* data_ = nullptr;
+    size_t size_ = 0;
+  };
+
+
+  namespace detail
+  {
+    [[noreturn]] void bytes_overrun(size_t offset, size_t wanted,
+                                    size_t size) CX_COLD;
+
+    // of type 'R', if 'T' is suitable
+    template <typename T, typename R = T>
+    using Trivial = std::enable_if_t<
+                      std::is_trivially_copyable<T>::value, R>;
+
+    template <typename T, typename R = T>
+    using Integer = std::enable_if_t<std::is_integral<T>::value, R>;
+  }
+
+
+  class ByteReader
+  {
+  public:
+    // a record of SIZE bytes, checked once by Take(); its fields'
+    // offsets are checked as it's compiled
+    template <size_t SIZE>
+    class Window
+    {
+    public:
+      template <typename T, size_t OFFSET>
+      detail::Trivial<T> Get() const
+      {
+        static_assert(OFFSET + sizeof(T) <= SIZE, "beyond the window");
+        T value;
+        memcpy(&value, data_ + OFFSET, sizeof(T));
+        return value;
+      }
+
+      template <typename T, size_t OFFSET>
+      detail::Integer<T> BE() const
+      {
+        return Endian::betoh(Get<T, OFFSET>());
+      }
+
+      template <typename T, size_t OFFSET>
+      detail::Integer<T> LE() const
+      {
+        return Endian::letoh(Get<T, OFFSET>());
+      }
+
+      template <size_t OFFSET, size_t COUNT>
+      ByteSpan Bytes() const
+      {
+        static_assert(OFFSET + COUNT <= SIZE, "beyond the window");
+        return { data_ + OFFSET, COUNT };
+      }
+
+    private:
+      friend class ByteReader;
+      explicit Window(U8 const* data) : data_(data) {}
+
+      U8 const* data_;
+    };
+
+    ByteReader(ByteSpan bytes) : bytes_(bytes) {}
+    ByteReader(void const* data, size_t size) : bytes_(data, size) {}
+
+    size_t Offset() const     { return offset_; }
+    size_t Remaining() const  { return bytes_.size() - offset_; }
+    bool AtEnd() const        { return offset_ == bytes_.size(); }
+
+    void Seek(size_t offset)
+    {
+      if (CX_UNLIKELY(offset > bytes_.size()))
+        detail::bytes_overrun(offset, 0, bytes_.size());
+      offset_ = offset;
+    }
+
+    void Skip(size_t count)
+    {
+      next(count);
+    }
+
+    // any trivially copyable type, as it is kept in memory; which
+    // for integers, means in the host's order
+    template <typename T>
+    detail::Trivial<T> Read()
+    {
+      T value;
+      memcpy(&value, next(sizeof(T)), sizeof(T));
+      return value;
+    }
+
+    template <typename T>
+    detail::Integer<T> ReadBE()
+    {
+      return Endian::betoh(Read<T>());
+    }
+
+    template <typename T>
+    detail::Integer<T> ReadLE()
+    {
+      return Endian::letoh(Read<T>());
+    }
+
+    ByteSpan ReadBytes(size_t count)
+    {
+      return { next(count), count };
+    }
+
+    std::string_view ReadString(size_t length)
+    {
+      return ReadBytes(length).View();
+    }
+
+    template <size_t SIZE>
+    Window<SIZE> Take()
+    {
+      return Window<SIZE>(next(SIZE));
+    }
+
+    // a reader of just the next 'count' bytes, which we move past;
+    // for records whose size is only known as they're read
+    ByteReader Split(size_t count)
+    {
+      return ReadBytes(count);
+    }
+
+  private:
+    // the next 'count' bytes, which we then move past
+    U8 const* next(size_t count)
+    {
+      if (CX_UNLIKELY(count > Remaining()))
+        detail::bytes_overrun(offset_, count, bytes_.size());
+
+      U8 const* at = bytes_.data() + offset_;
+      offset_ += count;
+      return at;
+    }
+
+    ByteSpan bytes_;
+    size_t offset_ = 0;
+  };
+
+
+  class ByteWriter
+  {
+  public:
+    // as ByteReader's
+    template <size_t SIZE>
+    class Window
+    {
+    public:
+      template <typename T, size_t OFFSET>
+      detail::Trivial<T, void> Put(T const& value)
+      {
+        static_assert(OFFSET + sizeof(T) <= SIZE, "beyond the window");
+        memcpy(data_ + OFFSET, &value, sizeof(T));
+      }
+
+      template <typename T, size_t OFFSET>
+      detail::Integer<T, void> PutBE(T value)
+      {
+        Put<T, OFFSET>(Endian::htobe(value));
+      }
+
+      template <typename T, size_t OFFSET>
+      detail::Integer<T, void> PutLE(T value)
+      {
+        Put<T, OFFSET>(Endian::htole(value));
+      }
+
+    private:
+      friend class ByteWriter;
+      explicit Window(U8* data) : data_(data) {}
+
+      U8* data_;
+    };
+
+    ByteWriter(void* data, size_t size)
+      : data_(static_cast<U8*>(data)), size_(size)
+    {
+    }
+
+    size_t Offset() const     { return offset_; }
+    size_t Remaining() const  { return size_ - offset_; }
+
+    // what has been written so far
+    ByteSpan Written() const
+    {
+      return { data_, offset_ };
+    }
+
+    void Seek(size_t offset)
+    {
+      if (CX_UNLIKELY(offset > size_))
+        detail::bytes_overrun(offset, 0, size_);
+      offset_ = offset;
+    }
+
+    // the counterparts of ByteReader's Read()s.  mind the type of
+    // 'value', since that is what's written; e.g. WriteBE<U16>(1).
+    template <typename T>
+    detail::Trivial<T, void> Write(T const& value)
+    {
+      memcpy(next(sizeof(T)), &value, sizeof(T));
+    }
+
+    template <typename T>
+    detail::Integer<T, void> WriteBE(T value)
+    {
+      Write(Endian::htobe(value));
+    }
+
+    template <typename T>
+    detail::Integer<T, void> WriteLE(T value)
+    {
+      Write(Endian::htole(value));
+    }
+
+    void WriteBytes(ByteSpan bytes)
+    {
+      U8* at = next(bytes.size());
+      if (!bytes.empty())
+        memcpy(at, bytes.data(), bytes.size());
+    }
+
+    void WriteString(std::string_view text)
+    {
+      WriteBytes({ text.data(), text.size() });
+    }
+
+    template <size_t SIZE>
+    Window<SIZE> Take()
+    {
+      return Window<SIZE>(next(SIZE));
+    }
+
+  private:
+    U8* next(size_t count)
+    {
+      if (CX_UNLIKELY(count > Remaining()))
+        detail::bytes_overrun(offset_, count, size_);
+
+      U8* at = data_ + offset_;
+      offset_ += count;
+      return at;
+    }
+
+    U8* data_;
+    size_t size_;
+    size_t offset_ = 0;
+  };
+
+
+  class MappedFile;
+  typedef Result<MappedFile, BytesException> MappedFileResult;
+
+  // a file, mapped read-only until we're destroyed
+  class MappedFile
+  {
+  public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    MappedFile(MappedFile const&) = delete;
+    MappedFile& operator=(MappedFile const&) = delete;
+
+    static MappedFileResult Open(char const* path);
+
+    ByteSpan Bytes() const
+    {
+      return { data_, size_ };
+    }
+
+  private:
+    void* data_ = nullptr;
+    size_t size_ = 0;
+  };
+
+} // namespace 'CX'
+
+#endif  // CX_ENDIANIO_HPP
@@ -0,0 +1,202 @@
+// vim: set tabstop=2 softtabstop=2 shiftwidth=2 expandtab :
+/*
+ * Copyright (c) 2026, Ryan V. Bissell
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ * See the enclosed "LICENSE" file for exact license terms.
+ */
+
+#ifndef CX_EPOCH_HPP
+#define CX_EPOCH_HPP
+
+// Epoch-based reclamation, for structures that are read through an
+// atomic pointer and replaced (never modified) by their writers.
+//
+// A reader brackets its use of the pointer with an Epoch::Guard; a
+// writer swaps in the replacement, and hands the old object to
+// Retire(), which frees it once every reader that might have seen
+// it has left its guard.  Readers never wait, and never write to
+// anything but their own thread's (cache-line sized) record.
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "cx-types.hpp"
+
+namespace CX {
+namespace Epoch {
+
+  // one per thread that has ever read; reused after the thread exits
+  struct alignas(64) Record
+  {
+    std::atomic<U64> active{0};   // the epoch read in, plus one; or 0
+    std::atomic<bool> owned{false};
+    Record* next = nullptr;
+  };
+
+
+  namespace detail
+  {
+    inline std::atomic<U64> g_epoch{1};
+    inline std::atomic<Record*> g_records{nullptr};
+
+    inline Record* claim()
+    {
+      for (Record* record = g_records.load(std::memory_order_acquire);
+           record; record = record->next)
+      {
+        bool expected = false;
+        if (!record->owned.load(std::memory_order_relaxed) &&
+            record->owned.compare_exchange_strong(expected, true))
+          return record;
+      }
+
+      Record* record = new Record;
+      record->owned.store(true, std::memory_order_relaxed);
+      Record* head = g_records.load(std::memory_order_relaxed);
+      do {
+        record->next = head;
+      } while (!g_records.compare_exchange_weak(head, record,
+                                                std::memory_order_release,
+                                                std::memory_order_relaxed));
+      return record;
+    }
+
+    // the calling thread's record, and how deeply it is nested in
+    // guards; the record goes back to the pool when the thread exits.
+    struct ThreadState
+    {
+      Record* record = claim();
+      unsigned depth = 0;
+
+      ~ThreadState()
+      {
+        record->active.store(0, std::memory_order_release);
+        record->owned.store(false, std::memory_order_release);
+      }
+    };
+
+    inline ThreadState& thread_state()
+    {
+      static thread_local ThreadState state;
+      return state;
+    }
+  }
+
+
+  // while one of these exists, nothing this thread loads from an
+  // epoch-protected pointer will be freed.  guards may nest.
+  class Guard
+  {
+  public:
+    Guard() : state_(detail::thread_state())
+    {
+      if (state_.depth++ == 0)
+      {
+        // seq_cst, so that the pointer load that follows can't be
+        // ordered before other threads see us as active
+        U64 epoch = detail::g_epoch.load(std::memory_order_seq_cst);
+        state_.record->active.store(epoch + 1, std::memory_order_seq_cst);
+      }
+    }
+
+    ~Guard()
+    {
+      if (--state_.depth == 0)
+        state_.record->active.store(0, std::memory_order_release);
+    }
+
+    Guard(Guard const&) = delete;
+    Guard& operator=(Guard const&) = delete;
+
+  private:
+    detail::ThreadState& state_;
+  };
+
+
+  // true when no reader remains that entered at or before 'epoch'
+  inline bool quiescent(U64 epoch)
+  {
+    for (Record const* record =
+           detail::g_records.load(std::memory_order_acquire);
+         record; record = record->next)
+    {
+      U64 active = record->active.load(std::memory_order_seq_cst);
+      if (active && ((active - 1) <= epoch))
+        return false;
+    }
+    return true;
+  }
+
+
+  // waits for every reader now in a guard to leave it; so anything
+  // unpublished before the call may be freed after it.  never call
+  // it from within a guard, which would wait for itself.
+  inline void synchronize()
+  {
+    U64 epoch = detail::g_epoch.fetch_add(1, std::memory_order_seq_cst);
+    while (!quiescent(epoch))
+      std::this_thread::yield();
+  }
+
+
+  // objects that writers have unpublished, waiting for their readers
+  // to leave.  not itself thread-safe; writers serialize around it.
+  template<typename T>
+  class Retired
+  {
+  public:
+    ~Retired()
+    {
+      // by now, nobody can be reading
+      for (auto const& retired : retired_)
+        delete retired.object;
+    }
+
+    // 'object' must already have been swapped out of its pointer
+    void Retire(T const* object)
+    {
+      if (!object)
+        return;
+
+      U64 epoch = detail::g_epoch.fetch_add(1, std::memory_order_seq_cst);
+      retired_.push_back({ object, epoch });
+      Collect();
+    }
+
+    // frees whatever no reader can still see
+    void Collect()
+    {
+      size_t kept = 0;
+      for (auto const& retired : retired_)
+      {
+        if (quiescent(retired.epoch))
+          delete retired.object;
+        else
+          retired_[kept++] = retired;
+      }
+      retired_.resize(kept);
+    }
+
+    size_t Pending() const
+    {
+      return retired_.size();
+    }
+
+  private:
+    struct Entry
+    {
+      T const* object;
+      U64 epoch;
+    };
+
+    std::vector<Entry> retired_;
+  };
+
+} // namespace 'Epoch'
+} // namespace 'CX'
+
+#endif  // CX_EPOCH_HPP
@@ -10,59 +10,400 @@
 #ifndef CX_EXCEPTIONS_HPP
 #define CX_EXCEPTIONS_HPP
 
-#include <map>
+#include <atomic>
 #include <iostream>
+#include <iterator>
+#include <utility>
+#include <type_traits>
 #include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include "cx-types.hpp"
 #include "cx-hackery.hpp"
 #include "cx-tracedebug.hpp"
 
-#define CX_EXCEPTIONSIZE 1024
+#ifdef CX_OPT_THROWSTATS
+#include "cx-throwstats.hpp"
+#endif
+
+#define CX_EXCEPTIONSIZE 1024     // longest formatted reason
+#define CX_EXCEPTIONARGSIZE 256   // captured reason format & args
+
+#ifndef CX_THROWSTACKDEPTH
+#define CX_THROWSTACKDEPTH 16     // return addresses kept, with THROWSTACK
+#endif
 
 namespace CX
 {
   extern const char* caught_message;
   extern const char* thrown_message;
+  extern const char* failed_message;
   extern const char* trace_reset_message;
 
+  namespace detail
+  {
+    // finds the filename part of a path; CX_THROW applies this to
+    // __FILE__ in a constant expression, so it costs nothing.
+    constexpr char const* basename(char const* path)
+    {
+      char const* base = path;
+      for (; *path; ++path)
+        if ((*path == '/') || (*path == '\\'))
+          base = path + 1;
+      return base;
+    }
+
+#ifdef CX_OPT_THROWSTACK
+    // while one of these is alive, exceptions built on this thread
+    // don't capture a stack; CX_FAIL uses it, because a Failure is
+    // just a return value until (and unless) somebody throws it.
+    extern thread_local U32 t_nostack;
+
+    struct NoStack
+    {
+      NoStack()   { ++t_nostack; }
+      ~NoStack()  { --t_nostack; }
+    };
+#endif
+
+    // the default argument promotions, as printf() will see them
+    template <typename D, typename = void>
+    struct ReasonPromote
+    {
+      typedef void const* type;   // pointers of any other kind
+    };
+
+    template <typename D>
+    struct ReasonPromote<D, std::enable_if_t<std::is_integral<D>::value>>
+    {
+      typedef decltype(+D()) type;
+    };
+
+    template <typename D>
+    struct ReasonPromote<D, std::enable_if_t<std::is_enum<D>::value>>
+    {
+      typedef decltype(+std::underlying_type_t<D>()) type;
+    };
+
+    template <typename D>
+    struct ReasonPromote<D,
+             std::enable_if_t<std::is_floating_point<D>::value>>
+    {
+      typedef std::conditional_t<std::is_same<D, long double>::value,
+                                 long double, double> type;
+    };
+
+    // a string argument, copied into the exception's capture buffer.
+    // 'offset' is relative to the start of that buffer.
+    template <typename TChar>
+    struct ReasonText
+    {
+      U16 offset;
+    };
+    enum: U16 { REASONNULL = 0xFFFF };
+
+    // the characters of the strings printf() knows; %s, or %ls
+    template <typename TChar>
+    using IsReasonChar = std::integral_constant<bool,
+                           std::is_same<TChar, char>::value ||
+                           std::is_same<TChar, signed char>::value ||
+                           std::is_same<TChar, unsigned char>::value ||
+                           std::is_same<TChar, wchar_t>::value>;
+
+    // how each printf-style argument of a reason is captured:
+    // numbers and pointers by (promoted) value, but strings by
+    // copying their text, since they may not survive unwinding.
+    template <typename T, typename D = std::decay_t<T>,
+              typename = void>
+    struct ReasonArg
+    {
+      static_assert(std::is_arithmetic<D>::value ||
+                    std::is_enum<D>::value ||
+                    std::is_pointer<D>::value ||
+                    std::is_null_pointer<D>::value,
+                    "exception reasons take printf-style arguments");
+
+      typedef typename ReasonPromote<D>::type Stored;
+
+      static Stored Pass(T const& value)
+      {
+        return (Stored)value;
+      }
+
+      static bool Capture(T const& value, char*, size_t&, Stored& out)
+      {
+        out = Pass(value);
+        return true;
+      }
+    };
+
+    template <typename T, typename D>
+    struct ReasonArg<T, D, std::enable_if_t<
+      std::is_pointer<D>::value &&
+      IsReasonChar<std::remove_cv_t<std::remove_pointer_t<D>>>::value>>
+    {
+      typedef std::remove_cv_t<std::remove_pointer_t<D>> TChar;
+      typedef ReasonText<TChar> Stored;
+
+      static TChar const* Pass(T const& value)
+      {
+        return value;
+      }
+
+      static bool Capture(T const& value, char* args, size_t& used,
+                          Stored& out)
+      {
+        TChar const* text = value;
+        if (!text)
+        {
+          out.offset = REASONNULL;
+          return true;
+        }
+
+        size_t count = 0;
+        while (text[count])
+          ++count;
+
+        // (the buffer itself is aligned for wide characters)
+        size_t at = (used + alignof(TChar) - 1) & ~(alignof(TChar) - 1);
+        size_t bytes = (count + 1) * sizeof(TChar);
+        if (at + bytes > CX_EXCEPTIONARGSIZE)
+          return false;
+
+        memcpy(args + at, text, bytes);
+        out.offset = (U16)at;
+        used = at + bytes;
+        return true;
+      }
+    };
+
+    // captured values are packed (unaligned) after a U16 that
+    // holds the offset of the captured format string
+    template <typename... TStored>
+    constexpr size_t reason_offset(size_t index)
+    {
+      constexpr size_t sizes[] = { sizeof(TStored)..., 0 };
+      size_t offset = sizeof(U16);
+      for (size_t i = 0; i < index; ++i)
+        offset += sizes[i];
+      return offset;
+    }
+
+    template <typename TStored>
+    TStored reason_load(char const* args, size_t offset)
+    {
+      TStored value;
+      memcpy(&value, args + offset, sizeof(value));
+      return value;
+    }
+
+    template <typename T>
+    T reason_restore(char const*, T value)
+    {
+      return value;
+    }
+
+    template <typename TChar>
+    TChar const* reason_restore(char const* args, ReasonText<TChar> text)
+    {
+      return (text.offset == REASONNULL) ? nullptr :
+               reinterpret_cast<TChar const*>(args + text.offset);
+    }
+
+    template <typename... TStored, size_t... I>
+    int format_reason_1(char* out, size_t size, char const* args,
+                        std::index_sequence<I...>)
+    {
+      U16 format;
+      memcpy(&format, args, sizeof(format));
+
+      return snprintf(out, size, args + format,
+                      reason_restore(args, reason_load<TStored>(
+                        args, reason_offset<TStored...>(I)))...);
+    }
+
+    template <typename... TStored>
+    int format_reason(char* out, size_t size, char const* args)
+    {
+      return format_reason_1<TStored...>(
+                out, size, args, std::index_sequence_for<TStored...>());
+    }
+  } // namespace 'detail'
+
+
   class BaseException
   {
   public:
     BaseException(const char* who, const char* where, const U32 what);
+    BaseException(BaseException const& other);
+    BaseException& operator=(BaseException const& other);
+    virtual ~BaseException();
 
     const char* Who() const     { return _who;    }
     const char* Where() const   { return _where;  }
-    const char* Reason() const  { return _reason; }
+    const char* Reason() const;   // formatted on first call
 
     virtual const char* Why() const = 0;
     virtual const char* Name() const = 0;
 
     virtual void StdError() const;
 
+#ifdef CX_OPT_THROWSTACK
+    // raw return addresses from where this was constructed, innermost
+    // first.  nothing is symbolized until the stack is printed.
+    U32 StackDepth() const          { return _stackdepth;  }
+    void* StackFrame(U32 i) const   { return _stack[i];    }
+    void PrintStack(FILE* file) const;
+
+    // for one built without a stack (by CX_FAIL), captures where
+    // it is about to be thrown from instead
+    void CaptureStack() CX_COLD;
+#endif
+
   protected:
     U32 What() const;     // what (code form of 'name')
     U32 _what;            // storage for what
 
     const char* _who;     // name of function throwing exception
-    const char* _where;   // source:line info
-    const char* _reason;  // optional, provides context-specific reason
+    const char* _where;   // source:line info (must be a static string)
+
+    // the optional, context-specific reason lives in _args; either
+    // already formatted (EAGER), or as copies of its format and
+    // arguments (LAZY), which Reason() formats into _reason.
+    enum: U8 { NOREASON, EAGER, LAZY };
+    typedef int (*Formatter)(char* out, size_t size, char const* args);
+
+    U8 _reasonstate;
+    Formatter _formatter;
+    mutable std::atomic<char*> _reason;
+    alignas(wchar_t) char _args[CX_EXCEPTIONARGSIZE];
 
-    char _wherebuffer[CX_EXCEPTIONSIZE];
-    void SetWhere(const char* where);
+#ifdef CX_OPT_THROWSTACK
+    U8 _stackdepth;
+    void* _stack[CX_THROWSTACKDEPTH];
+
+    void captureStack(void* start) CX_COLD;
+#endif
 
-    char _reasonbuffer[CX_EXCEPTIONSIZE];
     void SetReason(const char* format, va_list pArgs);
+
+    template <typename... TArgs>
+    void CaptureReason(const char* format, TArgs const&... args)
+    {
+      if (!format)
+        return;
+
+      if (!captureReason(std::index_sequence_for<TArgs...>(),
+                         format, args...))
+      {
+        // too big to keep; format it (truncated) right away instead
+        snprintf(_args, sizeof(_args), format,
+                 detail::ReasonArg<TArgs>::Pass(args)...);
+        _reasonstate = EAGER;
+      }
+    }
+
+  private:
+    template <size_t... I, typename... TArgs>
+    bool captureReason(std::index_sequence<I...>,
+                       const char* format, TArgs const&... args)
+    {
+      size_t used = detail::reason_offset<
+          typename detail::ReasonArg<TArgs>::Stored...>(sizeof...(I));
+
+      size_t len = strlen(format) + 1;
+      if (used + len > sizeof(_args))
+        return false;
+
+      U16 offset = (U16)used;
+      memcpy(_args, &offset, sizeof(offset));
+      memcpy(_args + used, format, len);
+      used += len;
+
+      bool ok = true;
+      auto capture = [&](auto const& arg, size_t at)
+      {
+        typedef detail::ReasonArg<
+                  std::remove_reference_t<decltype(arg)>> Arg;
+        typename Arg::Stored stored;
+        if (ok && (ok = Arg::Capture(arg, _args, used, stored)))
+          memcpy(_args + at, &stored, sizeof(stored));
+      };
+      (void)capture;
+      (capture(args, detail::reason_offset<
+                 typename detail::ReasonArg<TArgs>::Stored...>(I)), ...);
+      if (!ok)
+        return false;
+
+      _formatter = &detail::format_reason<
+                      typename detail::ReasonArg<TArgs>::Stored...>;
+      _reasonstate = LAZY;
+      return true;
+    }
   };
 
 
 
+  // one entry of an exception family's table of 'what' codes;
+  // see CX_DECLARE_EXCEPTION_CODES
+  template <typename TWhat>
+  struct ExceptionCode
+  {
+    TWhat what;
+    const char* name;
+    const char* why;
+  };
+
+  // every code of the family whose enum is 'TWhat', in enum order.
+  // the table is found via ADL, from the enum's own namespace.
+  template <typename TWhat>
+  constexpr auto const& exception_codes()
+  {
+    return cx_exception_codes(TWhat());
+  }
+
+  template <typename TWhat>
+  constexpr ExceptionCode<TWhat> const* find_exception_code(TWhat what)
+  {
+    auto const& codes = exception_codes<TWhat>();
+    U32 index = static_cast<U32>(what);
+    return (index < std::size(codes)) ? &codes[index] : nullptr;
+  }
+
+  namespace detail
+  {
+    template <typename TWhat, size_t N>
+    constexpr bool codes_in_order(ExceptionCode<TWhat> const (&codes)[N])
+    {
+      for (size_t i = 0; i < N; ++i)
+        if (static_cast<size_t>(codes[i].what) != i)
+          return false;
+      return true;
+    }
+  } // namespace 'detail'
+
+  // this is used (in the enum's namespace) to turn a family's
+  // X-macro list into its constexpr table, with X defined as
+  //   #define X(v,str) { Family::v, "Family::" #v, str },
+  #define CX_DECLARE_EXCEPTION_CODES(TEnum, ...)                      \
+    inline constexpr CX::ExceptionCode<TEnum> TEnum##Codes[] =        \
+    {                                                                 \
+      __VA_ARGS__                                                     \
+    };                                                                \
+    constexpr auto const& cx_exception_codes(TEnum)                   \
+    {                                                                 \
+      return TEnum##Codes;                                            \
+    }                                                                 \
+    static_assert(CX::detail::codes_in_order(TEnum##Codes),           \
+                  #TEnum " codes must be listed in enum order")
+
+
   // this design pattern is called "value-specialized template"
   // it is used to clone classes exactly, via a template
   template<typename Tag,
            typename TWhat,
-           std::map<TWhat, const char*>& TWhatNameMap,
-           std::map<TWhat, const char*>& TWhatStringMap,
            typename TBase=BaseException>
   class ExceptionTemplate: public TBase
   {
@@ -82,18 +423,17 @@ namespace CX
                       TWhat what=TWhat::NONE)
                       : TBase(who, where, static_cast<U32>(what))
     {
-      TBase::_reason = nullptr;
     }
 
+    // the reason's arguments are captured, not formatted; that
+    // only happens if and when somebody asks for Reason()
+    template <typename... TArgs>
     ExceptionTemplate(const char* who, const char* where,
-                      TWhat what=TWhat::NONE,
-                      const char* reason=nullptr, ...)
+                      TWhat what, const char* reason,
+                      TArgs const&... args)
                       : TBase(who, where, static_cast<U32>(what))
     {
-      va_list pArgs;
-      va_start(pArgs, reason);
-      TBase::SetReason(reason, pArgs);
-      va_end(pArgs);
+      TBase::CaptureReason(reason, args...);
     }
 
     TWhat What() const
@@ -107,12 +447,14 @@ namespace CX
     // it is indexed via the 'what' code.
     virtual const char* Why() const
     {
-      return TWhatStringMap[What()];
+      auto code = find_exception_code(What());
+      return code ? code->why : nullptr;
     }
 
     virtual const char* Name() const
     {
-      return TWhatNameMap[What()];
+      auto code = find_exception_code(What());
+      return code ? code->name : nullptr;
     }
   };
 
@@ -125,16 +467,17 @@ namespace CX
   {
     CX_EXCEPTIONS
   };
-  extern std::map<Error, const char*> ErrorNameMap;
-  extern std::map<Error, const char*> ErrorStringMap;
+  #undef X
+
+  #define X(v,str) { Error::v, "CXError::" #v, str },
+  CX_DECLARE_EXCEPTION_CODES(Error, CX_EXCEPTIONS);
   #undef X
 
   // this is used to declare exception types that derive
   // from CXBaseException
   #define CX_DECLARE_BASE_EXCEPTION_CLASS(Type, TEnum)                \
     typedef                                                           \
-    CX::ExceptionTemplate<struct Type##Tag, TEnum, TEnum##NameMap,    \
-    TEnum##StringMap> Type;
+    CX::ExceptionTemplate<struct Type##Tag, TEnum> Type;
 
   // CX::Exception is used for reporting error situations
   // that client code should be able to handle non-fatally.
@@ -145,19 +488,82 @@ namespace CX
   // See CX::Args::Exception for example.
   #define CX_DECLARE_EXCEPTION_CLASS(Type, TEnum, Base)               \
     typedef                                                           \
-    CX::ExceptionTemplate<struct Type##Tag, TEnum, TEnum##NameMap,    \
-    TEnum##StringMap, Base> Type;
+    CX::ExceptionTemplate<struct Type##Tag, TEnum, Base> Type;
+
+#ifdef CX_OPT_NOEXCEPTIONS
+  // without exceptions (-fno-exceptions), CX_THROW hands its
+  // exception to this handler instead; the handler must not return,
+  // but it may longjmp(3) (skipping the exception's destructor.)
+  // the default handler reports via StdError() and then aborts.
+  typedef void (*ThrowHandler)(BaseException const& exception);
+  ThrowHandler set_throw_handler(ThrowHandler handler);  // returns old
+
+  [[noreturn]] void throw_unhandled(BaseException const& exception)
+    CX_COLD;
+
+  namespace detail
+  {
+    // stands in for the exception that a CX_CATCH never receives
+    struct NoCatch
+    {
+      template <typename T>
+      operator T&() const
+      {
+        abort();
+      }
+    };
+  } // namespace 'detail'
+#endif
 
 } // namespace 'CX'
 
+#ifdef CX_OPT_NOEXCEPTIONS
+  #define CX_THROW_OBJECT(...) CX::throw_unhandled(__VA_ARGS__)
+#else
+  #define CX_THROW_OBJECT(...) throw __VA_ARGS__
+#endif
+
+// throwing only flushes the debug & error streams when there may be
+// something in them to flush; i.e., in builds with debug or trace
+// output compiled in.
+#if defined(CX_OPT_DEBUGOUT) || defined(CX_OPT_TRACING)
+  #define CX_THROW_FLUSH() CX::flush()
+#else
+  #define CX_THROW_FLUSH()
+#endif
+
+#ifdef CX_OPT_THROWSTATS
+  #define CX_THROW_COUNT(object, why)                                 \
+    static CX::ThrowStats::Site cx_throwsite =                        \
+      { cx_throw_where, __PRETTY_FUNCTION__, #object, #why };         \
+    CX::ThrowStats::count(cx_throwsite)
+#else
+  #define CX_THROW_COUNT(object, why)
+#endif
+
 #define CX_THROW(object, why, ...)                                    \
 {                                                                     \
   CX_DEBUGOUT(CX::thrown_message, cx_trace_methodname);               \
-  CX::flush();                                                        \
-  throw object(cx_trace_methodname,                                   \
-      __FILE__ ":" CX_STRINGIZE(__LINE__), why, __VA_ARGS__);         \
+  CX_THROW_FLUSH();                                                   \
+  constexpr char const* cx_throw_where =                              \
+      CX::detail::basename(__FILE__ ":" CX_STRINGIZE(__LINE__));      \
+  CX_THROW_COUNT(object, why);                                        \
+  CX_THROW_OBJECT(object(cx_trace_methodname, cx_throw_where,         \
+                         why, __VA_ARGS__));                          \
 }
 
+// without exceptions nothing is ever caught, so the CX_CATCH
+// block is compiled but dead.  (that also means 'type' must name
+// its variable, and catch (...) isn't available.)
+#ifdef CX_OPT_NOEXCEPTIONS
+  #define CX_TRY_BEGIN if (true) {
+  #define CX_CATCH_BEGIN(type)                                        \
+    } else { [[maybe_unused]] type = CX::detail::NoCatch();
+#else
+  #define CX_TRY_BEGIN try {
+  #define CX_CATCH_BEGIN(type) } catch (type) {
+#endif
+
 #ifdef CX_OPT_TRACING
   #define CX_TRACE_RESET                                              \
     CX::set_tracelevel(cx_catchlevel);                                \
@@ -166,12 +572,10 @@ namespace CX
   #define CX_TRY                                                      \
     CX_DIV0ASSERT(cx_traceflag); /* enforces use of CX_METHOD, etc */ \
     cx_catchlevel=CX::get_tracelevel();                               \
-    try {
+    CX_TRY_BEGIN
 
   #define CX_CATCH(type)                                              \
-    }                                                                 \
-    catch (type)                                                      \
-    {                                                                 \
+    CX_CATCH_BEGIN(type)                                              \
       CX_DIV0ASSERT(cx_catchlevel);                                   \
       CX_TRACE_RESET;                                                 \
       CX_DEBUGOUT(CX::caught_message, cx_trace_methodname);           \
@@ -179,8 +583,8 @@ namespace CX
 
   #define CX_ENDTRY }
 #else
-  #define CX_TRY try {
-  #define CX_CATCH(type) } catch (type) {
+  #define CX_TRY CX_TRY_BEGIN
+  #define CX_CATCH(type) CX_CATCH_BEGIN(type)
   #define CX_ENDTRY }
 #endif
 
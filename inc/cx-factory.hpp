@@ -10,27 +10,476 @@
 #ifndef CX_FACTORY_HPP
 #define CX_FACTORY_HPP
 
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <new>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <typeinfo>
 #include <unordered_map>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "cx-types.hpp"
+#include "cx-hackery.hpp"
+#include "cx-epoch.hpp"
+
+#ifdef CX_OPT_FACTORYSTATS
+#include "cx-factorystats.hpp"
+#include "cx-tracedebug.hpp"
+#endif
 
 namespace CX
 {
+  namespace FactoryStats
+  {
+    struct Product;
+  }
+
+
+  // constructor arguments are passed along as TCtorParams&&; so
+  // by-value parameters are copied at most once (see factory_arg()),
+  // and reference parameters aren't copied at all.
+  template<typename TBase, typename TClass, typename... TCtorParams>
+  TBase* CreateObject(TCtorParams&&... params)
+  {
+    return new TClass(std::forward<TCtorParams>(params)...);
+  }
+
+  template<typename TBase, typename TClass, typename... TCtorParams>
+  TBase* CreateObjectAt(void* storage, TCtorParams&&... params)
+  {
+    return new (storage) TClass(std::forward<TCtorParams>(params)...);
+  }
+
+
+  // New() takes whatever converts to its TCtorParams, and forwards it
+  // on as a TParam&&: as is, if it binds to that; else as a copy (or
+  // conversion), which an lvalue of a by-value TParam needs.
+  template<typename TParam, typename TArg>
+  decltype(auto) factory_arg(TArg&& arg)
+  {
+    if constexpr (std::is_convertible<TArg&&, TParam&&>::value)
+      return std::forward<TArg>(arg);
+    else
+      return TParam(std::forward<TArg>(arg));
+  }
+
+  template<typename TParams, typename TArgs, typename = void>
+  struct FactoryAccepts: std::false_type
+  {
+  };
+
+  template<typename... TParams, typename... TArgs>
+  struct FactoryAccepts<std::tuple<TParams...>, std::tuple<TArgs...>,
+                        std::enable_if_t<sizeof...(TParams) ==
+                                         sizeof...(TArgs)>>
+    : std::conjunction<std::is_convertible<TArgs&&, TParams>...>
+  {
+  };
+
+  // of New()'s template parameters, so that it takes only 'TArgs'
+  // that can be passed on as 'TParams' (a std::tuple of them)
+  template<typename TParams, typename... TArgs>
+  using FactoryArgs =
+    std::enable_if_t<FactoryAccepts<TParams,
+                                    std::tuple<TArgs...>>::value, bool>;
+
+
+  // how factory keys are spelled in stats reports, and in plugin
+  // manifests
+  template<typename TKey>
+  std::string factory_key_text(TKey const& key)
+  {
+    if constexpr (std::is_convertible<TKey const&, std::string_view>::value)
+      return std::string(std::string_view(key));
+    else if constexpr (std::is_enum<TKey>::value)
+      return factory_key_text(static_cast<std::underlying_type_t<TKey>>(key));
+    else if constexpr (std::is_integral<TKey>::value)
+      return std::to_string(key);
+    else
+      return "?";
+  }
+
+
+  // what a factory actually constructs for a TClass is a
+  // FactoryProduct<TClass>: TClass itself, unless built with
+  // CX_OPT_FACTORYSTATS, when it's (usually) a FactoryTracked<TClass>,
+  // which is bigger.  so storage for NewAt() is to be sized by
+  // Layout(), or by sizeof(FactoryProduct<TClass>); not sizeof(TClass).
+
+#ifdef CX_OPT_FACTORYSTATS
+  // what factories make of a TClass, so that its objects count
+  // themselves in and out.  Note that typeid() of such an object
+  // is not typeid(TClass), although dynamic_cast<TClass*> works.
+  template<typename TClass>
+  class FactoryTracked final: public TClass
+  {
+  public:
+    template<typename... TArgs>
+    FactoryTracked(FactoryStats::Product* product, TArgs&&... args)
+      : TClass(std::forward<TArgs>(args)...), product_(product)
+    {
+      FactoryStats::created(*product_);
+    }
+
+    ~FactoryTracked()
+    {
+      FactoryStats::destroyed(*product_);
+    }
+
+  private:
+    FactoryStats::Product* product_;
+  };
+
+  // final classes can't be derived from, and the others must be
+  // destroyed virtually for their destruction to be counted
+  template<typename TClass>
+  constexpr bool factory_tracks = !std::is_final<TClass>::value &&
+                                  std::has_virtual_destructor<TClass>::value;
+
+  template<typename TClass>
+  using FactoryProduct = std::conditional_t<factory_tracks<TClass>,
+                                            FactoryTracked<TClass>, TClass>;
+#else
+  template<typename TClass>
+  constexpr bool factory_tracks = false;
+
+  template<typename TClass>
+  using FactoryProduct = TClass;
+#endif
+
+  // as CreateObject(), but tracked when 'product' is given
+  template<typename TBase, typename TClass, typename... TCtorParams>
+  TBase* CreateProduct([[maybe_unused]] FactoryStats::Product* product,
+                       TCtorParams&&... params)
+  {
+#ifdef CX_OPT_FACTORYSTATS
+    if constexpr (factory_tracks<TClass>)
+      return new FactoryTracked<TClass>(product,
+                                        std::forward<TCtorParams>(params)...);
+#endif
+    return new TClass(std::forward<TCtorParams>(params)...);
+  }
+
+  template<typename TBase, typename TClass, typename... TCtorParams>
+  TBase* CreateProductAt([[maybe_unused]] FactoryStats::Product* product,
+                         void* storage, TCtorParams&&... params)
+  {
+#ifdef CX_OPT_FACTORYSTATS
+    if constexpr (factory_tracks<TClass>)
+      return new (storage) FactoryTracked<TClass>(
+                              product, std::forward<TCtorParams>(params)...);
+#endif
+    return new (storage) TClass(std::forward<TCtorParams>(params)...);
+  }
+
+
+  // what NewAt() needs from its caller's storage
+  struct FactoryLayout
+  {
+    size_t size;
+    size_t align;
+  };
+
+
+  // 'count' objects of one class, constructed side by side in a
+  // single cache-line aligned block, which they own; they are
+  // destroyed (last first) along with the batch.  Indexing or
+  // iterating a batch yields each object as a TBase*.
+  template<typename TBase>
+  class FactoryBatch
+  {
+  public:
+    enum { CACHELINE = 64 };
+
+    class iterator
+    {
+    public:
+      typedef std::forward_iterator_tag iterator_category;
+      typedef TBase* value_type;
+      typedef std::ptrdiff_t difference_type;
+      typedef TBase* const* pointer;
+      typedef TBase* reference;
+
+      iterator(char* object, size_t stride)
+        : object_(object), stride_(stride)
+      {
+      }
+
+      TBase* operator*() const
+      {
+        return std::launder(reinterpret_cast<TBase*>(object_));
+      }
 
+      iterator& operator++()
+      {
+        object_ += stride_;
+        return *this;
+      }
+
+      iterator operator++(int)
+      {
+        iterator before = *this;
+        object_ += stride_;
+        return before;
+      }
+
+      bool operator==(iterator const& other) const
+      {
+        return object_ == other.object_;
+      }
+
+      bool operator!=(iterator const& other) const
+      {
+        return object_ != other.object_;
+      }
+
+    private:
+      char* object_;
+      size_t stride_;
+    };
+
+    FactoryBatch() = default;
+
+    FactoryBatch(FactoryBatch&& other) noexcept
+    {
+      *this = std::move(other);
+    }
+
+    FactoryBatch& operator=(FactoryBatch&& other) noexcept
+    {
+      if (this != &other)
+      {
+        Reset();
+        block_ = std::exchange(other.block_, nullptr);
+        count_ = std::exchange(other.count_, 0);
+        stride_ = other.stride_;
+        offset_ = other.offset_;
+        align_ = other.align_;
+        destroy_ = other.destroy_;
+      }
+      return *this;
+    }
+
+    ~FactoryBatch()
+    {
+      Reset();
+    }
+
+    // destroys the objects, and frees their block
+    void Reset()
+    {
+      if (block_)
+        destroy_(block_, count_, align_);
+      block_ = nullptr;
+      count_ = 0;
+    }
+
+    TBase* operator[](size_t index) const
+    {
+      return std::launder(reinterpret_cast<TBase*>(
+                            block_ + offset_ + (index * stride_)));
+    }
+
+    iterator begin() const
+    {
+      return iterator(block_ + offset_, stride_);
+    }
+
+    iterator end() const
+    {
+      return iterator(block_ + offset_ + (count_ * stride_), stride_);
+    }
+
+    size_t size() const
+    {
+      return count_;
+    }
+
+    bool empty() const
+    {
+      return count_ == 0;
+    }
+
+    // bytes from one object to the next: sizeof() their class's
+    // FactoryProduct
+    size_t Stride() const
+    {
+      return stride_;
+    }
+
+    // empty, for no objects, or for more than memory could hold
+    template<typename TClass, typename... TArgs>
+    static FactoryBatch Of(size_t count, TArgs const&... args)
+    {
+      FactoryBatch batch;
+      if (!count || (count > (SIZE_MAX / sizeof(TClass))))
+        return batch;
+
+      batch.stride_ = sizeof(TClass);
+      batch.align_ = std::max<size_t>(CACHELINE, alignof(TClass));
+      batch.destroy_ = &destroyAll<TClass>;
+
+      // gives back whatever was built, if a constructor throws
+      struct Construction
+      {
+        char* block;
+        size_t built;
+        size_t align;
+
+        ~Construction()
+        {
+          if (block)
+            destroyAll<TClass>(block, built, align);
+        }
+      } construction = { static_cast<char*>(
+                           ::operator new(count * sizeof(TClass),
+                                          std::align_val_t(batch.align_))),
+                         0, batch.align_ };
+
+      for (; construction.built < count; ++construction.built)
+        new (construction.block + (construction.built * sizeof(TClass)))
+          TClass(args...);
+
+      TClass* first = std::launder(reinterpret_cast<TClass*>(
+                                     construction.block));
+      batch.offset_ = reinterpret_cast<char*>(static_cast<TBase*>(first)) -
+                      construction.block;
+      batch.block_ = std::exchange(construction.block, nullptr);
+      batch.count_ = count;
+      return batch;
+    }
+
+  private:
+    template<typename TClass>
+    static void destroyAll(char* block, size_t count, size_t align)
+    {
+      while (count--)
+        std::launder(reinterpret_cast<TClass*>(
+                       block + (count * sizeof(TClass))))->~TClass();
+      ::operator delete(block, std::align_val_t(align));
+    }
+
+    char* block_ = nullptr;
+    size_t count_ = 0;
+    size_t stride_ = 0;
+    size_t offset_ = 0;
+    size_t align_ = CACHELINE;
+    void (*destroy_)(char* block, size_t count, size_t align) = nullptr;
+  };
+
+
+  // every object of a batch is built from the same arguments, so
+  // they are passed by const reference (and so, can't be moved from.)
   template<typename TBase, typename TClass, typename... TCtorParams>
-  TBase* CreateObject(TCtorParams... params)
+  FactoryBatch<TBase> CreateBatch(
+                        [[maybe_unused]] FactoryStats::Product* product,
+                        size_t count, TCtorParams const&... params)
   {
-    return new TClass(params...);
+    if constexpr (!std::is_constructible<TClass,
+                                         TCtorParams const&...>::value)
+      return FactoryBatch<TBase>();   // see NewBatch()
+#ifdef CX_OPT_FACTORYSTATS
+    else if constexpr (factory_tracks<TClass>)
+      return FactoryBatch<TBase>::template Of<FactoryTracked<TClass>>(
+                                             count, product, params...);
+#endif
+    else
+      return FactoryBatch<TBase>::template Of<TClass>(count, params...);
   }
 
+
+  // everything a factory knows about one of its keys.  it can be
+  // called, like the bare function pointer it used to be.
+  template<typename TBase, typename... TCtorParams>
+  struct FactoryDefinition
+  {
+    TBase* (*create)(FactoryStats::Product* product,
+                     TCtorParams&&... params);
+    TBase* (*createAt)(FactoryStats::Product* product, void* storage,
+                       TCtorParams&&... params);
+    FactoryBatch<TBase> (*createBatch)(FactoryStats::Product* product,
+                                       size_t count,
+                                       TCtorParams const&... params);
+    FactoryLayout layout;
+    FactoryStats::Product* product;   // null without CX_OPT_FACTORYSTATS
+
+    template<typename... TArgs,
+             FactoryArgs<std::tuple<TCtorParams...>, TArgs...> = true>
+    TBase* operator()(TArgs&&... args) const
+    {
+      return create(product, factory_arg<TCtorParams>(
+                               std::forward<TArgs>(args))...);
+    }
+
+    template<typename... TArgs,
+             FactoryArgs<std::tuple<TCtorParams...>, TArgs...> = true>
+    TBase* NewAt(void* storage, TArgs&&... args) const
+    {
+      return createAt(product, storage, factory_arg<TCtorParams>(
+                                          std::forward<TArgs>(args))...);
+    }
+
+    FactoryBatch<TBase> NewBatch(size_t count,
+                                 TCtorParams const&... params) const
+    {
+      return createBatch(product, count, params...);
+    }
+
+#ifdef CX_OPT_FACTORYSTATS
+    // all zeros, for a class that isn't tracked (see factory_tracks)
+    FactoryStats::Counts Stats() const
+    {
+      return product ? FactoryStats::get_counts(*product)
+                     : FactoryStats::Counts{};
+    }
+#endif
+
+    template<typename TClass, typename TKey>
+    static FactoryDefinition Of([[maybe_unused]] TKey const& key)
+    {
+      FactoryDefinition definition =
+        { &CreateProduct<TBase, TClass, TCtorParams...>,
+          &CreateProductAt<TBase, TClass, TCtorParams...>,
+          &CreateBatch<TBase, TClass, TCtorParams...>,
+          { sizeof(FactoryProduct<TClass>),
+            alignof(FactoryProduct<TClass>) },
+          nullptr };
+
+#ifdef CX_OPT_FACTORYSTATS
+      if constexpr (factory_tracks<TClass>)
+      {
+        definition.product =
+          FactoryStats::enroll(factory_key_text(key),
+                               get_typename_view<TClass>(), sizeof(TClass));
+      }
+#endif
+      return definition;
+    }
+  };
+
+
   template<typename TBase, typename TKey, typename... TCtorParams>
   class Factory
   {
   protected:
-    typedef TBase *(*FactoryFunc)(TCtorParams... params);
+    typedef FactoryDefinition<TBase, TCtorParams...> FactoryFunc;
 
   public:
     typedef typename std::unordered_map<TKey, FactoryFunc> FFuncMap;
     typedef typename FFuncMap::const_iterator const_iterator;
     typedef typename FFuncMap::iterator iterator;
+    typedef FactoryFunc Definition;
 
     template<typename TClass>
     bool Define(TKey key)
@@ -38,18 +487,97 @@ namespace CX
       if (ffuncs_.find(key) != end())
         return false;
 
-      ffuncs_[key] = &CreateObject<TBase, TClass, TCtorParams...>;
+      ffuncs_[key] = FactoryFunc::template Of<TClass>(key);
       return true;
     }
 
-    TBase* New(TKey key, TCtorParams... params)
+    bool Undefine(TKey const& key)
+    {
+      return ffuncs_.erase(key) != 0;
+    }
+
+    Definition const* Find(TKey const& key) const
+    {
+      const_iterator iter = ffuncs_.find(key);
+      return (iter == cend()) ? nullptr : &iter->second;
+    }
+
+    bool Contains(TKey const& key) const
+    {
+      return ffuncs_.find(key) != cend();
+    }
+
+    template<typename... TArgs,
+             FactoryArgs<std::tuple<TCtorParams...>, TArgs...> = true>
+    TBase* New(TKey const& key, TArgs&&... args) const
+    {
+      const_iterator iter = ffuncs_.find(key);
+      if (iter == cend())
+        return nullptr;
+
+      return (iter->second)(std::forward<TArgs>(args)...);
+    }
+
+    // constructs into the caller's storage, which must be at least
+    // as big and as aligned as Layout(key) says (which is more than
+    // sizeof() its class, with CX_OPT_FACTORYSTATS; see FactoryProduct.)
+    // the caller destroys the object (by calling its virtual
+    // destructor) when done.
+    template<typename... TArgs,
+             FactoryArgs<std::tuple<TCtorParams...>, TArgs...> = true>
+    TBase* NewAt(TKey const& key, void* storage, TArgs&&... args) const
     {
       const_iterator iter = ffuncs_.find(key);
       if (iter == cend())
         return nullptr;
 
-      return (iter->second)(params...);
+      return iter->second.NewAt(storage, std::forward<TArgs>(args)...);
+    }
+
+    // 'count' objects of the key's class, in one allocation, each
+    // constructed from (copies of) the same 'params'.  empty for an
+    // unknown key, for a class that can't be constructed from const
+    // references to 'params', or for more objects than could fit in
+    // memory (if they could, but don't, std::bad_alloc is thrown.)
+    FactoryBatch<TBase> NewBatch(TKey const& key, size_t count,
+                                 TCtorParams const&... params) const
+    {
+      const_iterator iter = ffuncs_.find(key);
+      if (iter == cend())
+        return FactoryBatch<TBase>();
+
+      return iter->second.NewBatch(count, params...);
+    }
+
+    // that of the key's FactoryProduct; all zeros, for an unknown key
+    FactoryLayout Layout(TKey const& key) const
+    {
+      const_iterator iter = ffuncs_.find(key);
+      if (iter == cend())
+        return { 0, 0 };
+
+      return iter->second.layout;
+    }
+
+#ifdef CX_OPT_FACTORYSTATS
+    // all zeros, for an unknown key (or an untracked class.)  also
+    // see each Definition's Stats(), from cbegin() to cend().
+    FactoryStats::Counts Stats(TKey const& key) const
+    {
+      Definition const* definition = Find(key);
+      return definition ? definition->Stats() : FactoryStats::Counts{};
+    }
+
+    // as FactoryStats::report(), but for our keys only
+    void Report(FILE* file) const
+    {
+      std::vector<FactoryStats::Product const*> products;
+      for (auto const& defined : ffuncs_)
+        if (defined.second.product)
+          products.push_back(defined.second.product);
+      FactoryStats::report(file, std::move(products));
     }
+#endif
 
     const_iterator cbegin() const
     {
@@ -80,6 +608,1195 @@ namespace CX
     FFuncMap ffuncs_;
   };
 
+
+  // a Factory that may be defined into while other threads are
+  // creating from it.  Lookups read an immutable snapshot, under an
+  // Epoch::Guard, and so never lock or wait; each Define() (or
+  // Undefine()) copies the snapshot, changes the copy, publishes it,
+  // and retires the old one, which is freed once no lookup can still
+  // be using it.  So definitions cost O(keys), and are meant to be
+  // rare (e.g., as plugins load); they serialize with each other.
+  template<typename TBase, typename TKey, typename... TCtorParams>
+  class ConcurrentFactory
+  {
+  public:
+    typedef Factory<TBase, TKey, TCtorParams...> Snapshot;
+    typedef typename Snapshot::Definition Definition;
+
+    // called when New() (or NewAt(), etc.) can't find a key.  if it
+    // returns true, having presumably Define()d the key, the lookup is
+    // tried once more.  See CX::PluginLoader.
+    typedef std::function<bool(TKey const& key)> MissHook;
+
+    ConcurrentFactory() : snapshot_(new Snapshot)
+    {
+    }
+
+    ~ConcurrentFactory()
+    {
+      delete snapshot_.load(std::memory_order_relaxed);
+      delete missed_.load(std::memory_order_relaxed);
+    }
+
+    ConcurrentFactory(ConcurrentFactory const&) = delete;
+    ConcurrentFactory& operator=(ConcurrentFactory const&) = delete;
+
+    template<typename TClass>
+    bool Define(TKey key)
+    {
+      return update([&](Snapshot& next)
+                    {
+                      return next.template Define<TClass>(key);
+                    });
+    }
+
+    bool Undefine(TKey const& key)
+    {
+      return update([&](Snapshot& next)
+                    {
+                      return next.Undefine(key);
+                    });
+    }
+
+    // lookups load the hook under their guard; so this returns only
+    // once none can still be calling the old one (and so mustn't be
+    // called from within a lookup, or any Epoch::Guard.)
+    void SetMissHook(MissHook hook)
+    {
+      MissHook const* next = hook ? new MissHook(std::move(hook))
+                                  : nullptr;
+      MissHook const* previous =
+        missed_.exchange(next, std::memory_order_seq_cst);
+      if (previous)
+      {
+        Epoch::synchronize();
+        delete previous;
+      }
+    }
+
+    template<typename... TArgs,
+             FactoryArgs<std::tuple<TCtorParams...>, TArgs...> = true>
+    TBase* New(TKey const& key, TArgs&&... args) const
+    {
+      Epoch::Guard guard;
+      Definition const* defined = lookup(key);
+      if (!defined)
+        return nullptr;
+
+      return (*defined)(std::forward<TArgs>(args)...);
+    }
+
+    template<typename... TArgs,
+             FactoryArgs<std::tuple<TCtorParams...>, TArgs...> = true>
+    TBase* NewAt(TKey const& key, void* storage, TArgs&&... args) const
+    {
+      Epoch::Guard guard;
+      Definition const* defined = lookup(key);
+      if (!defined)
+        return nullptr;
+
+      return defined->NewAt(storage, std::forward<TArgs>(args)...);
+    }
+
+    FactoryBatch<TBase> NewBatch(TKey const& key, size_t count,
+                                 TCtorParams const&... params) const
+    {
+      Epoch::Guard guard;
+      Definition const* defined = lookup(key);
+      if (!defined)
+        return FactoryBatch<TBase>();
+
+      return defined->NewBatch(count, params...);
+    }
+
+    FactoryLayout Layout(TKey const& key) const
+    {
+      Epoch::Guard guard;
+      Definition const* defined = lookup(key);
+      if (!defined)
+        return { 0, 0 };
+
+      return defined->layout;
+    }
+
+    bool Contains(TKey const& key) const
+    {
+      Epoch::Guard guard;
+      return current()->Contains(key);
+    }
+
+    size_t size() const
+    {
+      Epoch::Guard guard;
+      return current()->size();
+    }
+
+    // calls 'visit' with the current snapshot, which stays valid (and
+    // unchanging) until 'visit' returns
+    template<typename TVisit>
+    void Visit(TVisit visit) const
+    {
+      Epoch::Guard guard;
+      visit(*current());
+    }
+
+    // snapshots replaced, but not yet freed
+    size_t Pending() const
+    {
+      std::lock_guard<std::mutex> lock(writer_);
+      retired_.Collect();
+      return retired_.Pending();
+    }
+
+  private:
+    Snapshot const* current() const
+    {
+      return snapshot_.load(std::memory_order_seq_cst);
+    }
+
+    // only valid while the caller's guard lasts
+    Definition const* lookup(TKey const& key) const
+    {
+      Definition const* defined = current()->Find(key);
+      if (CX_UNLIKELY(!defined))
+      {
+        MissHook const* missed = missed_.load(std::memory_order_seq_cst);
+        if (missed && (*missed)(key))
+          defined = current()->Find(key);
+      }
+      return defined;
+    }
+
+    template<typename TChange>
+    bool update(TChange change)
+    {
+      std::lock_guard<std::mutex> lock(writer_);
+
+      // only writers replace the snapshot, so ours is still current
+      Snapshot const* previous = snapshot_.load(std::memory_order_relaxed);
+      Snapshot* next = new Snapshot(*previous);
+      if (!change(*next))
+      {
+        delete next;
+        return false;
+      }
+
+      snapshot_.exchange(next, std::memory_order_seq_cst);
+      retired_.Retire(previous);
+      return true;
+    }
+
+    std::atomic<Snapshot const*> snapshot_;
+    mutable std::mutex writer_;
+    mutable Epoch::Retired<Snapshot> retired_;
+    std::atomic<MissHook const*> missed_ = { nullptr };
+  };
+
+
+  // a RecyclingFactory's counts, for one class
+  struct RecycleStats
+  {
+    U64 hits;       // New()s that reused a recycled object
+    U64 misses;     // ...that had to allocate one
+    U64 recycled;   // Recycle()s that kept their object
+    U64 dropped;    // ...that deleted it, the cache being full
+
+    double HitRate() const
+    {
+      U64 total = hits + misses;
+      return total ? static_cast<double>(hits) / total : 0.0;
+    }
+  };
+
+
+  // whether TClass has a Reset(TCtorParams...), for reuse
+  template<typename TClass, typename TVoid, typename... TCtorParams>
+  struct HasResetHook : std::false_type
+  {
+  };
+
+  template<typename TClass, typename... TCtorParams>
+  struct HasResetHook<TClass,
+                      std::void_t<decltype(std::declval<TClass&>().Reset(
+                                    std::declval<TCtorParams>()...))>,
+                      TCtorParams...> : std::true_type
+  {
+  };
+
+  // frees what 'new TClass' allocated, without destroying anything
+  template<typename TClass>
+  void FreeObjectStorage(void* memory)
+  {
+    if constexpr (alignof(TClass) > __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+      ::operator delete(memory, std::align_val_t(alignof(TClass)));
+    else
+      ::operator delete(memory);
+  }
+
+  // makes a recycled 'object' as good as new: by its Reset() hook, if
+  // it has one, or else by destroying and reconstructing it in place.
+  // if that throws, the object is gone (and its memory freed.)
+  template<typename TBase, typename TClass, typename... TCtorParams>
+  TBase* ReuseObject(TBase* object, TCtorParams&&... params)
+  {
+    TClass* derived = static_cast<TClass*>(object);
+    if constexpr (HasResetHook<TClass, void, TCtorParams&&...>::value)
+    {
+      struct Resetting
+      {
+        TClass* object;
+        ~Resetting() { delete object; }
+      } resetting = { derived };
+
+      derived->Reset(std::forward<TCtorParams>(params)...);
+      resetting.object = nullptr;
+      return derived;
+    }
+    else
+    {
+      derived->~TClass();
+      struct Storage
+      {
+        void* memory;
+        ~Storage()
+        {
+          if (memory)
+            FreeObjectStorage<TClass>(memory);
+        }
+      } storage = { derived };
+
+      TClass* reused = new (storage.memory)
+                         TClass(std::forward<TCtorParams>(params)...);
+      storage.memory = nullptr;
+      return reused;
+    }
+  }
+
+  template<typename TBase, typename TClass>
+  void DeleteObject(TBase* object)
+  {
+    delete static_cast<TClass*>(object);
+  }
+
+
+  // a Factory whose objects can be handed back with Recycle(), to be
+  // reused by a later New() of the same class instead of going back to
+  // the heap.  Recycled objects are cached per class and per thread
+  // (so New() and Recycle() take no locks), at most 'capacity' of each;
+  // beyond that, Recycle() just deletes them.  Objects from New() are
+  // ordinary heap objects, and may also be deleted as usual.
+  //
+  // As with Factory, Define() must not race with anything else; New()
+  // and Recycle() are safe from any threads.  Objects recycled by a
+  // thread stay cached until the factory is destroyed, or the thread
+  // exits, whichever comes first.
+  template<typename TBase, typename TKey, typename... TCtorParams>
+  class RecyclingFactory
+  {
+    struct Class
+    {
+      TBase* (*create)(TCtorParams&&... params);
+      TBase* (*reuse)(TBase* object, TCtorParams&&... params);
+      void (*destroy)(TBase* object);
+    };
+
+    // one class's cache, within one thread's
+    struct Slot
+    {
+      std::vector<TBase*> objects;
+      void (*destroy)(TBase* object);
+
+      // only the owning thread writes these; anyone may read them
+      std::atomic<U64> hits{0};
+      std::atomic<U64> misses{0};
+      std::atomic<U64> recycled{0};
+      std::atomic<U64> dropped{0};
+
+      ~Slot()
+      {
+        for (TBase* object : objects)
+          destroy(object);
+      }
+    };
+
+    // one thread's caches; shared by that thread and the factory
+    struct Cache
+    {
+      std::mutex growing;   // held when 'slots' changes, or is summed
+      std::vector<std::unique_ptr<Slot>> slots;
+      std::atomic<bool> orphaned{false};  // its factory is gone
+    };
+
+  public:
+    explicit RecyclingFactory(size_t capacity = 64)
+      : capacity_(capacity), id_(nextId())
+    {
+    }
+
+    // every thread's cache is drained now, not when that thread
+    // exits; the threads drop the empty caches when they next look.
+    // (as with any object, nobody may still be using the factory.)
+    ~RecyclingFactory()
+    {
+      std::lock_guard<std::mutex> lock(caches_lock_);
+      for (auto const& cache : caches_)
+      {
+        std::lock_guard<std::mutex> growing(cache->growing);
+        for (auto& slot : cache->slots)
+        {
+          for (TBase* object : slot->objects)
+            (slot->destroy)(object);
+          slot->objects.clear();
+        }
+        cache->orphaned.store(true, std::memory_order_release);
+      }
+    }
+
+    RecyclingFactory(RecyclingFactory const&) = delete;
+    RecyclingFactory& operator=(RecyclingFactory const&) = delete;
+
+    template<typename TClass>
+    bool Define(TKey key)
+    {
+      static_assert(std::is_base_of<TBase, TClass>::value,
+                    "factory classes must derive from TBase");
+
+      if (keys_.find(key) != keys_.end())
+        return false;
+
+      size_t index = classOf(typeid(TClass));
+      if (index == defined_.size())
+      {
+        types_.push_back(&typeid(TClass));
+        defined_.push_back({
+          &CreateObject<TBase, TClass, TCtorParams...>,
+          &ReuseObject<TBase, TClass, TCtorParams...>,
+          &DeleteObject<TBase, TClass> });
+        retired_.push_back({ 0, 0, 0, 0 });
+      }
+
+      keys_[key] = index;
+      return true;
+    }
+
+    template<typename... TArgs,
+             FactoryArgs<std::tuple<TCtorParams...>, TArgs...> = true>
+    TBase* New(TKey const& key, TArgs&&... args)
+    {
+      auto iter = keys_.find(key);
+      if (iter == keys_.end())
+        return nullptr;
+
+      Class const& defined = defined_[iter->second];
+      Slot& slot = localSlot(iter->second);
+      if (CX_LIKELY(!slot.objects.empty()))
+      {
+        TBase* object = slot.objects.back();
+        slot.objects.pop_back();
+        bump(slot.hits);
+        return (defined.reuse)(object, factory_arg<TCtorParams>(
+                                         std::forward<TArgs>(args))...);
+      }
+
+      bump(slot.misses);
+      return (defined.create)(factory_arg<TCtorParams>(
+                                std::forward<TArgs>(args))...);
+    }
+
+    // 'object' must have come from this factory's New(), or at least
+    // be of one of its classes; if not, it is simply deleted.
+    void Recycle(TBase* object)
+    {
+      if (!object)
+        return;
+
+      size_t index = classOf(typeid(*object));
+      if (index == defined_.size())
+      {
+        delete object;
+        return;
+      }
+
+      Slot& slot = localSlot(index);
+      if (slot.objects.size() >= capacity_)
+      {
+        bump(slot.dropped);
+        (defined_[index].destroy)(object);
+        return;
+      }
+
+      slot.objects.push_back(object);
+      bump(slot.recycled);
+    }
+
+    // summed over every thread, for the key's class (which other
+    // keys may share); all zeros for an unknown key
+    RecycleStats Stats(TKey const& key) const
+    {
+      auto iter = keys_.find(key);
+      if (iter == keys_.end())
+        return { 0, 0, 0, 0 };
+
+      size_t index = iter->second;
+      std::lock_guard<std::mutex> lock(caches_lock_);
+      RecycleStats stats = retired_[index];
+      for (auto const& cache : caches_)
+      {
+        std::lock_guard<std::mutex> growing(cache->growing);
+        if (index < cache->slots.size())
+          addStats(stats, *cache->slots[index]);
+      }
+      return stats;
+    }
+
+    size_t Capacity() const
+    {
+      return capacity_;
+    }
+
+    size_t size() const
+    {
+      return keys_.size();
+    }
+
+  private:
+    // an index into defined_; or its size(), if 'type' isn't there.
+    // factories rarely have many classes, so a search beats hashing
+    // the type's name.
+    size_t classOf(std::type_info const& type) const
+    {
+      size_t index = 0;
+      for (; index < types_.size(); ++index)
+        if (*types_[index] == type)
+          break;
+      return index;
+    }
+
+    static U64 nextId()
+    {
+      static std::atomic<U64> ids(0);
+      return ++ids;
+    }
+
+    // counters are only ever written by their own thread; so unlike
+    // fetch_add(), this needs no locked instruction
+    static void bump(std::atomic<U64>& counter)
+    {
+      counter.store(counter.load(std::memory_order_relaxed) + 1,
+                    std::memory_order_relaxed);
+    }
+
+    static void addStats(RecycleStats& stats, Slot const& slot)
+    {
+      stats.hits += slot.hits.load(std::memory_order_relaxed);
+      stats.misses += slot.misses.load(std::memory_order_relaxed);
+      stats.recycled += slot.recycled.load(std::memory_order_relaxed);
+      stats.dropped += slot.dropped.load(std::memory_order_relaxed);
+    }
+
+    Slot& localSlot(size_t index)
+    {
+      Cache& cache = localCache();
+      if (CX_UNLIKELY(index >= cache.slots.size()))
+        growCache(cache);
+      return *cache.slots[index];
+    }
+
+    // this thread's caches, for every RecyclingFactory of this type
+    // it has used; they are found by id, since addresses get reused.
+    Cache& localCache()
+    {
+      struct Local
+      {
+        U64 id = 0;         // of the last factory used, ...
+        Cache* cache = nullptr;   // ...and its cache
+        std::unordered_map<U64, std::shared_ptr<Cache>> caches;
+      };
+      static thread_local Local local;
+
+      if (CX_LIKELY(local.id == id_))
+        return *local.cache;
+
+      if (local.caches.find(id_) == local.caches.end())
+        forgetOrphans(local.caches);
+
+      std::shared_ptr<Cache>& cache = local.caches[id_];
+      if (!cache)
+      {
+        cache = std::make_shared<Cache>();
+        enroll(cache);
+      }
+
+      local.id = id_;
+      local.cache = cache.get();
+      return *cache;
+    }
+
+    // lets go of the (already drained) caches of dead factories
+    template<typename TCaches>
+    CX_COLD static void forgetOrphans(TCaches& caches)
+    {
+      for (auto iter = caches.begin(); iter != caches.end(); )
+      {
+        if (iter->second->orphaned.load(std::memory_order_acquire))
+          iter = caches.erase(iter);
+        else
+          ++iter;
+      }
+    }
+
+    CX_COLD void enroll(std::shared_ptr<Cache> const& cache)
+    {
+      std::lock_guard<std::mutex> lock(caches_lock_);
+
+      // caches that only we still hold belong to threads that have
+      // exited; keep their counts, and let their objects go
+      size_t kept = 0;
+      for (auto& old : caches_)
+      {
+        if (old.use_count() == 1)
+        {
+          for (size_t i = 0; i < old->slots.size(); ++i)
+            addStats(retired_[i], *old->slots[i]);
+          old.reset();
+        }
+        else
+          caches_[kept++] = std::move(old);
+      }
+      caches_.resize(kept);
+
+      caches_.push_back(cache);
+    }
+
+    CX_COLD void growCache(Cache& cache)
+    {
+      std::lock_guard<std::mutex> growing(cache.growing);
+      while (cache.slots.size() < defined_.size())
+      {
+        std::unique_ptr<Slot> slot(new Slot);
+        slot->objects.reserve(capacity_);
+        slot->destroy = defined_[cache.slots.size()].destroy;
+        cache.slots.push_back(std::move(slot));
+      }
+    }
+
+    size_t capacity_;
+    U64 id_;
+
+    std::unordered_map<TKey, size_t> keys_;          // to defined_
+    std::vector<std::type_info const*> types_;       // of defined_
+    std::vector<Class> defined_;
+
+    mutable std::mutex caches_lock_;
+    std::vector<std::shared_ptr<Cache>> caches_;
+    std::vector<RecycleStats> retired_;   // from exited threads
+  };
+
+
+  // the hash FrozenFactory uses; strings are hashed as string_views,
+  // so that lookups needn't construct a std::string.
+  template<typename TKey>
+  struct FrozenHash
+  {
+    size_t operator()(TKey const& key) const
+    {
+      return std::hash<TKey>()(key);
+    }
+  };
+
+  template<>
+  struct FrozenHash<std::string>
+  {
+    size_t operator()(std::string_view key) const
+    {
+      return std::hash<std::string_view>()(key);
+    }
+  };
+
+
+  // an immutable copy of a Factory, for once registration is over.
+  // Small sets are searched linearly; larger ones go through a
+  // hash-and-displace perfect hash, so that every lookup probes
+  // exactly one slot.  Lookups may use any type that compares with
+  // TKey (such as a string_view, for std::string keys), and callers
+  // that already know a key's Hash() can pass it in.
+  template<typename TBase, typename TKey, typename... TCtorParams>
+  class FrozenFactory
+  {
+    typedef Factory<TBase, TKey, TCtorParams...> TFactory;
+    typedef typename TFactory::FFuncMap::mapped_type FactoryFunc;
+
+    enum { SMALL = 8 };     // at most this many: no perfect hash
+    enum { GROWTHS = 64 };  // that many tries, each a bit bigger
+
+    struct Entry
+    {
+      TKey key;
+      size_t hash;
+      FactoryFunc func;
+    };
+
+  public:
+    explicit FrozenFactory(TFactory const& factory)
+    {
+      for (auto iter = factory.cbegin(); iter != factory.cend(); ++iter)
+        entries_.push_back({ iter->first, Hash(iter->first),
+                             iter->second });
+
+      size_ = entries_.size();
+      if (size_ > SMALL)
+        buildPerfectHash();
+    }
+
+    template<typename TLookup>
+    static size_t Hash(TLookup const& key)
+    {
+      return FrozenHash<TKey>()(key);
+    }
+
+    template<typename TLookup>
+    bool Contains(TLookup const& key) const
+    {
+      return find(key, Hash(key)) != nullptr;
+    }
+
+    template<typename TLookup, typename... TArgs,
+             FactoryArgs<std::tuple<TCtorParams...>, TArgs...> = true>
+    TBase* New(TLookup const& key, TArgs&&... args) const
+    {
+      return NewHashed(key, Hash(key), std::forward<TArgs>(args)...);
+    }
+
+    template<typename TLookup, typename... TArgs,
+             FactoryArgs<std::tuple<TCtorParams...>, TArgs...> = true>
+    TBase* NewHashed(TLookup const& key, size_t hash,
+                     TArgs&&... args) const
+    {
+      Entry const* entry = find(key, hash);
+      if (!entry)
+        return nullptr;
+
+      return (entry->func)(std::forward<TArgs>(args)...);
+    }
+
+    // as Factory::NewAt()
+    template<typename TLookup, typename... TArgs,
+             FactoryArgs<std::tuple<TCtorParams...>, TArgs...> = true>
+    TBase* NewAt(TLookup const& key, void* storage, TArgs&&... args) const
+    {
+      Entry const* entry = find(key, Hash(key));
+      if (!entry)
+        return nullptr;
+
+      return entry->func.NewAt(storage, std::forward<TArgs>(args)...);
+    }
+
+    template<typename TLookup>
+    FactoryBatch<TBase> NewBatch(TLookup const& key, size_t count,
+                                 TCtorParams const&... params) const
+    {
+      Entry const* entry = find(key, Hash(key));
+      if (!entry)
+        return FactoryBatch<TBase>();
+
+      return entry->func.NewBatch(count, params...);
+    }
+
+    template<typename TLookup>
+    FactoryLayout Layout(TLookup const& key) const
+    {
+      Entry const* entry = find(key, Hash(key));
+      if (!entry)
+        return { 0, 0 };
+
+      return entry->func.layout;
+    }
+
+    size_t size() const
+    {
+      return size_;
+    }
+
+  private:
+    static U64 mix(U64 hash, U64 seed)
+    {
+      // splitmix64's finalizer
+      hash ^= seed * 0x9E3779B97F4A7C15ULL;
+      hash = (hash ^ (hash >> 30)) * 0xBF58476D1CE4E5B9ULL;
+      hash = (hash ^ (hash >> 27)) * 0x94D049BB133111EBULL;
+      return hash ^ (hash >> 31);
+    }
+
+    static size_t reduce(U64 hash, size_t range)
+    {
+      return static_cast<size_t>(
+          (static_cast<unsigned __int128>(hash) * range) >> 64);
+    }
+
+    size_t slotOf(size_t hash) const
+    {
+      U32 seed = seeds_[reduce(mix(hash, 0), seeds_.size())];
+      return reduce(mix(hash, seed), entries_.size());
+    }
+
+    template<typename TLookup>
+    Entry const* find(TLookup const& key, size_t hash) const
+    {
+      if (seeds_.empty())
+      {
+        for (auto const& entry : entries_)
+          if ((entry.hash == hash) && (entry.key == key))
+            return &entry;
+        return nullptr;
+      }
+
+      Entry const& entry = entries_[slotOf(hash)];
+      if ((entry.hash == hash) && entry.func.create && (entry.key == key))
+        return &entry;
+      return nullptr;
+    }
+
+    // places the keys bucket by bucket, biggest first, finding for
+    // each bucket a seed that sends all of its keys to free slots.
+    // if some bucket can't be placed, the table grows a little and
+    // we start over; so the table is only nearly minimal at worst.
+    // keys whose hashes are equal can't be placed at any size, though;
+    // for those (or after GROWTHS tries), lookups search linearly.
+    void buildPerfectHash()
+    {
+      std::vector<Entry> keys;
+      keys.swap(entries_);
+
+      std::vector<size_t> hashes;
+      for (auto const& key : keys)
+        hashes.push_back(key.hash);
+      std::sort(hashes.begin(), hashes.end());
+      if (std::adjacent_find(hashes.begin(), hashes.end()) == hashes.end())
+      {
+        size_t slots = keys.size();
+        size_t buckets = (keys.size() + 3) / 4;
+        for (int tries = 0; tries < GROWTHS; ++tries)
+        {
+          if (tryPerfectHash(keys, slots, buckets))
+            return;
+          slots += (slots / 16) + 1;
+        }
+      }
+
+      seeds_.clear();
+      entries_.swap(keys);
+    }
+
+    bool tryPerfectHash(std::vector<Entry> const& keys,
+                        size_t slots, size_t buckets)
+    {
+      std::vector<std::vector<size_t>> members(buckets);
+      for (size_t i = 0; i < keys.size(); ++i)
+        members[reduce(mix(keys[i].hash, 0), buckets)].push_back(i);
+
+      std::vector<size_t> order(buckets);
+      for (size_t b = 0; b < buckets; ++b)
+        order[b] = b;
+      std::stable_sort(order.begin(), order.end(),
+                       [&](size_t a, size_t b)
+                       {
+                         return members[a].size() > members[b].size();
+                       });
+
+      std::vector<bool> taken(slots, false);
+      std::vector<size_t> placed;
+      seeds_.assign(buckets, 0);
+      entries_.assign(slots, Entry { TKey(), 0, FactoryFunc() });
+
+      for (size_t b : order)
+      {
+        if (members[b].empty())
+          break;
+
+        U32 seed = 1;
+        for (; seed < (1U << 16); ++seed)
+        {
+          placed.clear();
+          for (size_t i : members[b])
+          {
+            size_t slot = reduce(mix(keys[i].hash, seed), slots);
+            if (taken[slot] ||
+                (std::find(placed.begin(), placed.end(), slot) !=
+                 placed.end()))
+              break;
+            placed.push_back(slot);
+          }
+          if (placed.size() == members[b].size())
+            break;
+        }
+        if (placed.size() != members[b].size())
+          return false;
+
+        seeds_[b] = seed;
+        for (size_t n = 0; n < placed.size(); ++n)
+        {
+          taken[placed[n]] = true;
+          entries_[placed[n]] = keys[members[b][n]];
+        }
+      }
+
+      return true;
+    }
+
+    std::vector<Entry> entries_;
+    std::vector<U32> seeds_;      // per bucket; empty when linear
+    size_t size_ = 0;
+  };
+
+
+  // allocation policies for AllocFactory.  A policy needs only
+  //   void* Allocate(size_t size, size_t align);
+  //   void Deallocate(void* memory, size_t size, size_t align);
+  class HeapPolicy
+  {
+  public:
+    void* Allocate(size_t size, size_t align)
+    {
+      return ::operator new(size, std::align_val_t(align));
+    }
+
+    void Deallocate(void* memory, size_t size, size_t align)
+    {
+      ::operator delete(memory, size, std::align_val_t(align));
+    }
+  };
+
+
+  // any std::pmr::memory_resource, not owned
+  class ResourcePolicy
+  {
+  public:
+    explicit ResourcePolicy(std::pmr::memory_resource* resource)
+      : resource_(resource)
+    {
+    }
+
+    void* Allocate(size_t size, size_t align)
+    {
+      return resource_->allocate(size, align);
+    }
+
+    void Deallocate(void* memory, size_t size, size_t align)
+    {
+      resource_->deallocate(memory, size, align);
+    }
+
+  private:
+    std::pmr::memory_resource* resource_;
+  };
+
+
+  // bump allocation, from the caller's buffer first (if given) and
+  // then from 'upstream'.  Deallocate() does nothing; Release() frees
+  // everything at once, so it must only be called when no objects
+  // from this arena remain (their handles having been destroyed.)
+  class ArenaPolicy
+  {
+  public:
+    explicit ArenaPolicy(std::pmr::memory_resource* upstream =
+                           std::pmr::get_default_resource())
+      : arena_(upstream)
+    {
+    }
+
+    ArenaPolicy(void* buffer, size_t size,
+                std::pmr::memory_resource* upstream =
+                  std::pmr::get_default_resource())
+      : arena_(buffer, size, upstream)
+    {
+    }
+
+    void* Allocate(size_t size, size_t align)
+    {
+      return arena_.allocate(size, align);
+    }
+
+    void Deallocate(void*, size_t, size_t)
+    {
+    }
+
+    void Release()
+    {
+      arena_.release();
+    }
+
+  private:
+    std::pmr::monotonic_buffer_resource arena_;
+  };
+
+
+  // recycles freed blocks, pooled by size; so each type (or at least
+  // each size of type) draws from its own free list.  not thread-safe.
+  class PoolPolicy
+  {
+  public:
+    explicit PoolPolicy(std::pmr::memory_resource* upstream =
+                          std::pmr::get_default_resource())
+      : pool_(upstream)
+    {
+    }
+
+    void* Allocate(size_t size, size_t align)
+    {
+      return pool_.allocate(size, align);
+    }
+
+    void Deallocate(void* memory, size_t size, size_t align)
+    {
+      pool_.deallocate(memory, size, align);
+    }
+
+    void Release()
+    {
+      pool_.release();
+    }
+
+  private:
+    std::pmr::unsynchronized_pool_resource pool_;
+  };
+
+
+  // destroys an AllocFactory object as the class it was created as,
+  // and returns its memory to the policy it came from
+  template<typename TBase, typename TPolicy>
+  struct AllocDeleter
+  {
+    TPolicy* policy;
+    void (*destroy)(TBase* object, TPolicy* policy);
+
+    void operator()(TBase* object) const
+    {
+      if (object)
+        destroy(object, policy);
+    }
+  };
+
+  template<typename TBase, typename TPolicy, typename TClass>
+  void DestroyObject(TBase* object, TPolicy* policy)
+  {
+    TClass* derived = static_cast<TClass*>(object);
+    derived->~TClass();
+    policy->Deallocate(derived, sizeof(TClass), alignof(TClass));
+  }
+
+  template<typename TBase, typename TPolicy, typename TClass,
+           typename... TCtorParams>
+  std::unique_ptr<TBase, AllocDeleter<TBase, TPolicy>>
+  AllocateObject(TPolicy& policy, TCtorParams&&... params)
+  {
+    // hands the memory back if the constructor throws
+    struct Reservation
+    {
+      TPolicy& policy;
+      void* memory;
+
+      ~Reservation()
+      {
+        if (memory)
+          policy.Deallocate(memory, sizeof(TClass), alignof(TClass));
+      }
+    } reservation = { policy,
+                      policy.Allocate(sizeof(TClass), alignof(TClass)) };
+
+    TClass* object = new (reservation.memory)
+                       TClass(std::forward<TCtorParams>(params)...);
+    reservation.memory = nullptr;
+
+    AllocDeleter<TBase, TPolicy> deleter =
+      { &policy, &DestroyObject<TBase, TPolicy, TClass> };
+    return std::unique_ptr<TBase, AllocDeleter<TBase, TPolicy>>(
+                                                      object, deleter);
+  }
+
+
+  // like Factory, but objects come from 'TPolicy' (which must outlive
+  // them) and are returned as owning handles.
+  template<typename TBase, typename TKey, typename TPolicy,
+           typename... TCtorParams>
+  class AllocFactory
+  {
+  public:
+    typedef AllocDeleter<TBase, TPolicy> Deleter;
+    typedef std::unique_ptr<TBase, Deleter> Handle;
+
+  protected:
+    typedef Handle (*FactoryFunc)(TPolicy& policy,
+                                  TCtorParams&&... params);
+
+  public:
+    typedef typename std::unordered_map<TKey, FactoryFunc> FFuncMap;
+    typedef typename FFuncMap::const_iterator const_iterator;
+
+    template<typename... TPolicyParams>
+    explicit AllocFactory(TPolicyParams&&... params)
+      : policy_(std::forward<TPolicyParams>(params)...)
+    {
+    }
+
+    template<typename TClass>
+    bool Define(TKey key)
+    {
+      static_assert(std::is_base_of<TBase, TClass>::value,
+                    "factory classes must derive from TBase");
+
+      if (ffuncs_.find(key) != ffuncs_.end())
+        return false;
+
+      ffuncs_[key] = &AllocateObject<TBase, TPolicy, TClass,
+                                     TCtorParams...>;
+      return true;
+    }
+
+    template<typename... TArgs,
+             FactoryArgs<std::tuple<TCtorParams...>, TArgs...> = true>
+    Handle New(TKey key, TArgs&&... args)
+    {
+      const_iterator iter = ffuncs_.find(key);
+      if (iter == cend())
+        return Handle(nullptr, Deleter { &policy_, nullptr });
+
+      return (iter->second)(policy_, factory_arg<TCtorParams>(
+                                       std::forward<TArgs>(args))...);
+    }
+
+    TPolicy& Policy()
+    {
+      return policy_;
+    }
+
+    const_iterator cbegin() const
+    {
+      return ffuncs_.cbegin();
+    }
+
+    const_iterator cend() const
+    {
+      return ffuncs_.cend();
+    }
+
+    size_t size() const
+    {
+      return ffuncs_.size();
+    }
+
+  private:
+    TPolicy policy_;
+    FFuncMap ffuncs_;
+  };
+
+
+  // a Factory for a closed set of classes, known at compile time,
+  // whose objects are made by value in a std::variant; so nothing is
+  // allocated, and std::visit() calls them without virtual dispatch.
+  // Each class names its own key, as a constant convertible to TKey:
+  //   static constexpr std::string_view FactoryKey = "circle";
+  // IndexOf() is constexpr, so a literal key can be resolved at
+  // compile time, and New<IndexOf("circle")>(...) involves no lookup.
+  template<typename TKey, typename... TTypes>
+  class VariantFactory
+  {
+  public:
+    typedef std::variant<TTypes...> Value;
+
+    static constexpr size_t npos = sizeof...(TTypes);
+
+    static constexpr TKey Keys[] = { TKey(TTypes::FactoryKey)... };
+
+    // the index of the key's class in TTypes (and in Value); or npos
+    static constexpr size_t IndexOf(TKey const& key)
+    {
+      for (size_t index = 0; index < npos; ++index)
+        if (Keys[index] == key)
+          return index;
+      return npos;
+    }
+
+    static constexpr TKey KeyOf(Value const& value)
+    {
+      return Keys[value.index()];
+    }
+
+    template<size_t Index, typename... TArgs>
+    static Value New(TArgs&&... args)
+    {
+      static_assert(Index < npos, "no such VariantFactory key");
+      return Value(std::in_place_index<Index>,
+                   std::forward<TArgs>(args)...);
+    }
+
+    // empty for an unknown key, or for a class that can't be built
+    // from 'args'
+    template<typename... TArgs>
+    static std::optional<Value> New(TKey const& key, TArgs&&... args)
+    {
+      std::optional<Value> value;
+      Emplace(value, key, std::forward<TArgs>(args)...);
+      return value;
+    }
+
+    // constructs directly into 'value' (replacing whatever was there),
+    // e.g. an element of a vector; false, and unchanged, for an
+    // unknown key or a class that can't be built from 'args'
+    template<typename TValue, typename... TArgs>
+    static bool Emplace(TValue& value, TKey const& key, TArgs&&... args)
+    {
+      size_t index = IndexOf(key);
+      if (index == npos)
+        return false;
+
+      return emplaceAt(std::index_sequence_for<TTypes...>(), index,
+                       value, std::forward<TArgs>(args)...);
+    }
+
+  private:
+    static constexpr bool uniqueKeys()
+    {
+      for (size_t i = 0; i < npos; ++i)
+        for (size_t j = i + 1; j < npos; ++j)
+          if (Keys[i] == Keys[j])
+            return false;
+      return true;
+    }
+
+    static_assert(npos > 0, "a VariantFactory needs some classes");
+    static_assert(uniqueKeys(), "VariantFactory keys must be unique");
+
+    template<size_t... Indices, typename TValue, typename... TArgs>
+    static bool emplaceAt(std::index_sequence<Indices...>, size_t index,
+                          TValue& value, TArgs&&... args)
+    {
+      typedef bool (*Emplacer)(TValue& value, TArgs&&... args);
+      static constexpr Emplacer emplacers[] =
+        { &emplace<Indices, TValue, TArgs...>... };
+      return emplacers[index](value, std::forward<TArgs>(args)...);
+    }
+
+    // 'value' is a Value, or a std::optional of one
+    template<size_t Index, typename TValue, typename... TArgs>
+    static bool emplace(TValue& value, TArgs&&... args)
+    {
+      typedef std::variant_alternative_t<Index, Value> TType;
+      if constexpr (!std::is_constructible<TType, TArgs&&...>::value)
+        return false;
+      else if constexpr (std::is_same<TValue, Value>::value)
+      {
+        value.template emplace<Index>(std::forward<TArgs>(args)...);
+        return true;
+      }
+      else
+      {
+        value.emplace(std::in_place_index<Index>,
+                      std::forward<TArgs>(args)...);
+        return true;
+      }
+    }
+  };
+
 }
 
 #endif  // CX_FACTORY_HPP
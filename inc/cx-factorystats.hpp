@@ -0,0 +1,105 @@
+// vim: set tabstop=2 softtabstop=2 shiftwidth=2 expandtab :
+/*
+ * Copyright (c) 2026, Ryan V. Bissell
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ * See the enclosed "LICENSE" file for exact license terms.
+ */
+
+#ifndef CX_FACTORYSTATS_HPP
+#define CX_FACTORYSTATS_HPP
+
+// NOTE: this header is pulled into cx-factory.hpp when
+// CX_OPT_FACTORYSTATS is set.  Factories then make each of their
+// classes as a FactoryTracked<> of it, which counts itself in and
+// out of its key's Product below.
+
+#include <atomic>
+#include <stdio.h>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "cx-types.hpp"
+#include "cx-hackery.hpp"
+
+namespace CX {
+namespace FactoryStats {
+
+  // as with ThrowStats, counts are kept in a few cache-line sized
+  // shards per product, and each thread always bumps the same one.
+  enum { SHARDS = 8 };
+
+  // peak live objects are only sampled, every SAMPLE creations per
+  // shard (and whenever counts are read); so a short-lived spike
+  // may go unseen.
+  enum { SAMPLE = 16 };
+
+  struct alignas(64) Shard
+  {
+    std::atomic<U64> created{0};
+    std::atomic<U64> destroyed{0};
+  };
+
+  // one per key defined into a factory.  Products are never freed,
+  // since the objects counted by them may outlive their factory.
+  struct Product
+  {
+    std::string key;      // as factory_key_text() spells it
+    std::string type;     // the class defined for the key
+    size_t size;          // sizeof() that class
+
+    std::atomic<U64> peak{0};
+    Product* next = nullptr;
+    Shard shards[SHARDS] = {};
+  };
+
+  struct Counts
+  {
+    U64 created;
+    U64 live;
+    U64 peak;
+    U64 bytes;            // live * size
+    U64 peakbytes;        // peak * size
+  };
+
+  Product* enroll(std::string_view key, std::string_view type,
+                  size_t size) CX_COLD;
+  unsigned next_shard();
+  void sample(Product& product);
+
+  inline unsigned get_shard()
+  {
+    static thread_local unsigned shard = next_shard();
+    return shard;
+  }
+
+  inline void created(Product& product)
+  {
+    Shard& shard = product.shards[get_shard()];
+    U64 count = shard.created.fetch_add(1, std::memory_order_relaxed);
+    if (CX_UNLIKELY((count % SAMPLE) == 0))
+      sample(product);
+  }
+
+  inline void destroyed(Product& product)
+  {
+    Shard& shard = product.shards[get_shard()];
+    shard.destroyed.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  // every product, most recently enrolled first
+  Product const* get_products();
+  Counts get_counts(Product const& product);
+
+  // writes one line per product, most live bytes first.  If
+  // CX_FACTORYSTATS names a file (or is '-', for stderr) this also
+  // happens automatically at exit, for every product.
+  void report(FILE* file);
+  void report(FILE* file, std::vector<Product const*> products);
+
+} // namespace 'FactoryStats'
+} // namespace 'CX'
+
+#endif // CX_FACTORYSTATS_HPP
@@ -12,7 +12,12 @@
 
 #include "cx-types.hpp"
 
+// constant, where the compiler says what the host's order is
+#if defined(__BYTE_ORDER__)
+#define CX_HOST_IS_BIG_ENDIAN (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+#else
 #define CX_HOST_IS_BIG_ENDIAN (*(U16 *)"\0\xff" < 0x100)
+#endif
 #define CX_HOST_IS_LITTLE_ENDIAN (!CX_HOST_IS_BIG_ENDIAN)
 
 
@@ -60,6 +65,9 @@
 #define CX_STRINGIZE2(n) #n
 #define CX_STRINGIZE(n) CX_STRINGIZE2(n)
 
+#define CX_CONCAT2(a, b) a##b
+#define CX_CONCAT(a, b) CX_CONCAT2(a, b)
+
 #ifdef __GNUC__
 #define CX_LIKELY(x)   __builtin_expect(!!(x), 1)
 #define CX_UNLIKELY(x) __builtin_expect(!!(x), 0)
@@ -68,6 +76,22 @@
 #define CX_UNLIKELY(x) (x)
 #endif
 
+// for slow paths: keeps them out of line, and out of the
+// hot text section, of their callers
+#ifdef __GNUC__
+#define CX_COLD __attribute__((cold, noinline))
+#else
+#define CX_COLD
+#endif
+
+// for printf()-like functions; 'fmt' is the (1-based) position of
+// the format string, and 'first' that of the first of its arguments
+#ifdef __GNUC__
+#define CX_PRINTF(fmt, first) __attribute__((format(printf, fmt, first)))
+#else
+#define CX_PRINTF(fmt, first)
+#endif
+
 #define CX_FINAL final
 
 #endif // CX_HACKERY_HPP
@@ -0,0 +1,94 @@
+// vim: set tabstop=2 softtabstop=2 shiftwidth=2 expandtab :
+/*
+ * Copyright (c) 2026, Ryan V. Bissell
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ * See the enclosed "LICENSE" file for exact license terms.
+ */
+
+#ifndef CX_PERFCOUNTERS_HPP
+#define CX_PERFCOUNTERS_HPP
+
+// NOTE: this header is pulled into cx-tracedebug.hpp when
+// CX_OPT_PERFCOUNTERS is set, so keep it free of templates
+// and of heavyweight standard headers.
+
+#include <stdio.h>
+
+#include "cx-types.hpp"
+
+namespace CX {
+namespace Perf {
+
+  // where the per-thread counter group gets its numbers from.
+  // HARDWARE is a perf_event_open(2) group of cycles, instructions,
+  // LLC misses and branch misses.  When the kernel (or container)
+  // won't give us those, we drop to SOFTWARE perf events (task-clock,
+  // context switches, page faults, cpu migrations) and, failing even
+  // that, to CLOCK (thread cputime and getrusage(2) equivalents.)
+  enum class Source: U32
+  {
+    NONE,
+    HARDWARE,
+    SOFTWARE,
+    CLOCK,
+  };
+
+  enum { SLOTS = 4 };
+
+  struct Sample
+  {
+    U64 value[SLOTS];
+  };
+
+  struct Stats
+  {
+    U64 calls;
+    Sample total;   // inclusive of nested scopes
+  };
+
+  // opens the calling thread's counter group on first use;
+  // the environment variable CX_PERFSOURCE ('hardware', 'software'
+  // or 'clock') selects the first source to try.
+  Source get_source();
+  char const* get_slot_name(Source source, int slot);
+
+  void read_counters(Sample& sample);
+  void record(char const* method, Sample const& start);
+
+  // aggregated over every thread that has recorded anything
+  bool get_stats(char const* method, Stats& stats);
+  void reset();
+
+  // writes one line per method, with IPC and misses-per-thousand
+  // instructions for HARDWARE.  If CX_PERFREPORT names a file (or
+  // is '-', for stderr) this also happens automatically at exit.
+  void report(FILE* file);
+
+
+  class Scope
+  {
+  public:
+    explicit Scope(char const* method) : method_(method)
+    {
+      read_counters(start_);
+    }
+
+    ~Scope()
+    {
+      record(method_, start_);
+    }
+
+    Scope(Scope const&) = delete;
+    Scope& operator=(Scope const&) = delete;
+
+  private:
+    char const* method_;
+    Sample start_;
+  };
+
+} // namespace 'Perf'
+} // namespace 'CX'
+
+#endif // CX_PERFCOUNTERS_HPP
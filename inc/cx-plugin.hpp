@@ -0,0 +1,241 @@
+// vim: set tabstop=2 softtabstop=2 shiftwidth=2 expandtab :
+/*
+ * Copyright (c) 2026, Ryan V. Bissell
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ * See the enclosed "LICENSE" file for exact license terms.
+ */
+
+#ifndef CX_PLUGIN_HPP
+#define CX_PLUGIN_HPP
+
+// Plugins are shared objects that Define() their classes into the
+// factories of whatever loads them.  Each one has an entry point,
+//
+//   CX_PLUGIN_ENTRY(host)
+//   {
+//     auto codecs = host.Find<CodecFactory>("codecs");
+//     if (!codecs)
+//       return false;
+//     codecs->Define<Mp3Codec>("mp3");
+//     return true;
+//   }
+//
+// and the loading program Publish()es its factories by name (the
+// same names the plugins Find() them by), and then Scan()s for
+// plugins.  A plugin 'foo.so' may come with a manifest, 'foo.cxplugin',
+// saying what it defines: one 'factory key' per line (with '#'
+// comments.)  Such plugins aren't loaded by Scan(), but only once a
+// ConcurrentFactory misses one of their keys; so startup doesn't slow
+// down as plugins are added.  Plugins without manifests are loaded by
+// Scan().
+//
+// A plain Factory may be published too, but its misses load nothing,
+// since it can't be defined into while other threads create from it.
+// For the same reason, no other thread may be using it while any
+// plugin loads; which, with manifests, is whenever a ConcurrentFactory
+// misses.
+//
+// Plugins are never unloaded, since objects of their classes may
+// live on.  A program whose plugins define into ConcurrentFactory
+// (or RecyclingFactory) must be linked with -rdynamic; otherwise each
+// plugin gets its own copies of the statics in CX's headers, such as
+// the reclamation epochs, and those must be shared.
+
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <typeinfo>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "cx-types.hpp"
+#include "cx-exceptions.hpp"
+#include "cx-result.hpp"
+#include "cx-factory.hpp"
+
+#define CX_PLUGIN_ENTRYNAME "cx_plugin_register"
+
+#define CX_PLUGIN_ENTRY(host)                                         \
+  extern "C" bool cx_plugin_register(CX::PluginHost& host)
+
+namespace CX
+{
+  #define CX_PLUGIN_EXCEPTIONS                                        \
+    X(OPEN,       "Unable to load the plugin.")                      \
+    X(NOENTRY,    "The plugin has no " CX_PLUGIN_ENTRYNAME "().")    \
+    X(REJECTED,   "The plugin's entry point failed.")                \
+    X(DIRECTORY,  "Unable to read the plugin directory.")            \
+    X(MANIFEST,   "The plugin's manifest is malformed.")
+
+  #define X(v,str) v,
+  enum class PluginError: U32
+  {
+    CX_PLUGIN_EXCEPTIONS
+  };
+  #undef X
+
+  #define X(v,str) { PluginError::v, "CXPluginError::" #v, str },
+  CX_DECLARE_EXCEPTION_CODES(PluginError, CX_PLUGIN_EXCEPTIONS);
+  #undef X
+
+  CX_DECLARE_BASE_EXCEPTION_CLASS(PluginException, PluginError);
+
+  typedef Result<void, PluginException> PluginResult;
+  typedef Result<size_t, PluginException> PluginCount;
+
+
+  // what a plugin's entry point is given.  it is all virtual (or
+  // inline), so that plugins needn't link against libcx.
+  class PluginHost
+  {
+  public:
+    // the factory published by that name, if it is a TFactory
+    template<typename TFactory>
+    TFactory* Find(char const* name) const
+    {
+      return static_cast<TFactory*>(find(name, typeid(TFactory).name()));
+    }
+
+    // of the plugin being registered
+    virtual char const* Path() const = 0;
+
+  protected:
+    virtual ~PluginHost() {}
+    virtual void* find(char const* name, char const* type) const = 0;
+  };
+
+  typedef bool (*PluginEntry)(PluginHost& host);
+
+
+  // the factories whose misses load plugins (see the top of this file)
+  template<typename TFactory>
+  constexpr bool plugin_loads_lazily = false;
+
+  template<typename TBase, typename TKey, typename... TCtorParams>
+  constexpr bool plugin_loads_lazily<ConcurrentFactory<TBase, TKey,
+                                                       TCtorParams...>> =
+    true;
+
+
+  // see the top of this file.  thread-safe; ConcurrentFactories may
+  // miss (and so load plugins) from any thread.
+  class PluginLoader: private PluginHost
+  {
+  public:
+    PluginLoader() = default;
+    ~PluginLoader();
+
+    PluginLoader(PluginLoader const&) = delete;
+    PluginLoader& operator=(PluginLoader const&) = delete;
+
+    // 'factory' (a Factory or ConcurrentFactory) must outlive us.  a
+    // ConcurrentFactory's miss hook is ours from now on, until we're
+    // destroyed; which waits for any lookup still calling it.
+    template<typename TFactory>
+    void Publish(char const* name, TFactory& factory)
+    {
+      std::string published(name);
+      if constexpr (!plugin_loads_lazily<TFactory>)
+        publish(published, &factory, typeid(TFactory).name(), nullptr);
+      else
+      {
+        publish(published, &factory, typeid(TFactory).name(),
+                [](void* unhooked)
+                {
+                  static_cast<TFactory*>(unhooked)->SetMissHook(nullptr);
+                });
+
+        size_t const salt = std::hash<std::string>()(published);
+        factory.SetMissHook(
+          [this, published, salt](auto const& key)
+          {
+            typedef std::decay_t<decltype(key)> TKey;
+            size_t const hash = salt ^ std::hash<TKey>()(key);
+            if (unclaimed(hash))
+              return false;
+            return loadFor(published, factory_key_text(key), hash);
+          });
+      }
+    }
+
+    // loads a plugin now, manifest or not
+    PluginResult Load(char const* path);
+
+    // finds the plugins ('*' 'suffix') in 'directory', loading those
+    // without manifests and deferring the others; returns how many
+    // were found.  failing to load a plugin doesn't fail the scan,
+    // but is noted in Failures().
+    PluginCount Scan(char const* directory, char const* suffix = ".so");
+
+    size_t Loaded() const;
+    size_t Deferred() const;
+
+    struct Failure
+    {
+      std::string path;
+      std::string reason;
+    };
+
+    std::vector<Failure> Failures() const;
+
+  private:
+    enum class State: U8
+    {
+      DEFERRED,
+      LOADING,    // its entry point is running
+      LOADED,
+      FAILED,
+    };
+
+    struct Plugin
+    {
+      std::string path;
+      State state;
+      void* handle;
+    };
+
+    struct Published
+    {
+      void* factory;
+      char const* type;
+      void (*unhook)(void* factory);    // null, if it has no hook
+    };
+
+    void publish(std::string const& name, void* factory, char const* type,
+                 void (*unhook)(void* factory));
+    bool unclaimed(size_t hash) const;
+    bool loadFor(std::string const& factory, std::string const& key,
+                 size_t hash);
+    PluginResult load(size_t index);
+    PluginResult open(Plugin& plugin);
+    PluginResult readManifest(std::string const& path, size_t index);
+
+    char const* Path() const override;
+    void* find(char const* name, char const* type) const override;
+
+    // recursive, since a plugin's entry point calls find()
+    mutable std::recursive_mutex lock_;
+    std::vector<Plugin> plugins_;
+    std::unordered_map<std::string, Published> published_;
+    std::unordered_map<std::string, size_t> deferred_;  // to plugins_
+    std::vector<Failure> failures_;
+    char const* registering_ = nullptr;
+
+    // keys that no plugin claimed when they last missed, so that
+    // missing them again needn't lock (or build strings.)  each is
+    // the hash of its factory's name and the key, mixed with the
+    // generation of deferred_ it went unclaimed in.
+    enum { UNCLAIMED = 64 };
+    std::atomic<size_t> unclaimed_[UNCLAIMED] = {};
+    std::atomic<size_t> generation_ = { 0 };
+  };
+
+} // namespace 'CX'
+
+#endif  // CX_PLUGIN_HPP
@@ -0,0 +1,170 @@
+// vim: set tabstop=2 softtabstop=2 shiftwidth=2 expandtab :
+/*
+ * Copyright (c) 2026, Ryan V. Bissell
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ * See the enclosed "LICENSE" file for exact license terms.
+ */
+
+#ifndef CX_RESULT_HPP
+#define CX_RESULT_HPP
+
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+#include "cx-types.hpp"
+#include "cx-hackery.hpp"
+#include "cx-tracedebug.hpp"
+#include "cx-exceptions.hpp"
+
+namespace CX
+{
+  // what a failing function hands back instead of throwing;
+  // 'E' is one of the exception families (an ExceptionTemplate),
+  // kept by value, so no unwinding and no heap is involved.
+  template <typename E>
+  struct Failure
+  {
+    E error;
+  };
+
+
+  // either a 'T' or the exception that would have been thrown.
+  // the failure must be of exactly the family 'E', since storing
+  // a derived family in an 'E' would slice off its codes.
+  template <typename T, typename E = Exception>
+  class Result
+  {
+    static_assert(std::is_base_of<BaseException, E>::value,
+                  "Result<> failures must be CX exceptions");
+
+    // a successful Result<void> holds nothing in particular
+    typedef std::conditional_t<std::is_void<T>::value,
+                               std::monostate, T> Stored;
+
+  public:
+    Result() : state_(std::in_place_index<0>)
+    {
+    }
+
+    template <typename U, typename = std::enable_if_t<
+                std::is_constructible<Stored, U&&>::value &&
+                !std::is_same<std::decay_t<U>, Result>::value>>
+    Result(U&& value) : state_(std::in_place_index<0>,
+                               std::forward<U>(value))
+    {
+    }
+
+    Result(Failure<E>&& failure)
+      : state_(std::in_place_index<1>, std::move(failure.error))
+    {
+    }
+
+    Result(Failure<E> const& failure)
+      : state_(std::in_place_index<1>, failure.error)
+    {
+    }
+
+    bool Ok() const   { return state_.index() == 0; }
+    explicit operator bool() const  { return Ok(); }
+
+    Stored& Value() &
+    {
+      CX_ASSERT(Ok(), "Value() of a failed Result\n");
+      return *std::get_if<0>(&state_);
+    }
+
+    Stored const& Value() const&
+    {
+      CX_ASSERT(Ok(), "Value() of a failed Result\n");
+      return *std::get_if<0>(&state_);
+    }
+
+    Stored&& Value() &&
+    {
+      CX_ASSERT(Ok(), "Value() of a failed Result\n");
+      return std::move(*std::get_if<0>(&state_));
+    }
+
+    E const& Error() const
+    {
+      CX_ASSERT(!Ok(), "Error() of a successful Result\n");
+      return *std::get_if<1>(&state_);
+    }
+
+    // passes our failure on, as the failure of another Result
+    // (of any 'T') in the same family; see CX_PROPAGATE
+    Failure<E> Forward() &&
+    {
+      CX_ASSERT(!Ok(), "Forward() of a successful Result\n");
+      return Failure<E> { std::move(*std::get_if<1>(&state_)) };
+    }
+
+    // for API boundaries where exceptions are the norm
+    [[noreturn]] void Throw() const
+    {
+      CX_ASSERT(!Ok(), "Throw() of a successful Result\n");
+      CX_THROW_FLUSH();
+#ifdef CX_OPT_THROWSTACK
+      // CX_FAIL left the stack for now, when it's worth having
+      E thrown(*std::get_if<1>(&state_));
+      thrown.CaptureStack();
+      CX_THROW_OBJECT(thrown);
+#else
+      CX_THROW_OBJECT(*std::get_if<1>(&state_));
+#endif
+    }
+
+    Stored ValueOrThrow() &&
+    {
+      if (CX_UNLIKELY(!Ok()))
+        Throw();
+      return std::move(*std::get_if<0>(&state_));
+    }
+
+  private:
+    std::variant<Stored, E> state_;
+  };
+
+} // namespace 'CX'
+
+
+#ifdef CX_OPT_THROWSTACK
+  #define CX_FAIL_NOSTACK() CX::detail::NoStack cx_fail_nostack
+#else
+  #define CX_FAIL_NOSTACK()
+#endif
+
+// the Result counterpart to CX_THROW; it must be used within a
+// CX_METHOD (or CX_FUNCTION) that returns a Result of 'object'.
+// with CX_OPT_THROWSTACK, the stack is only captured by Throw().
+#define CX_FAIL(object, why, ...)                                     \
+{                                                                     \
+  CX_DEBUGOUT(CX::failed_message, cx_trace_methodname);               \
+  CX_FAIL_NOSTACK();                                                  \
+  constexpr char const* cx_fail_where =                               \
+      CX::detail::basename(__FILE__ ":" CX_STRINGIZE(__LINE__));      \
+  CX_RETURN(CX::Failure<object> {                                     \
+      object(cx_trace_methodname, cx_fail_where, why, __VA_ARGS__) });  \
+}
+
+// evaluates a Result, and returns its failure (if any) to our caller
+#define CX_PROPAGATE(result)                                          \
+{                                                                     \
+  auto&& cx_propagated = (result);                                    \
+  if (CX_UNLIKELY(!cx_propagated))                                    \
+    CX_RETURN(std::move(cx_propagated).Forward());                    \
+}
+
+// like CX_PROPAGATE, but also declares (or assigns) the value, e.g.
+//   CX_UNWRAP(U64 size, get_size(path));
+#define CX_UNWRAP(declaration, result)                                \
+  auto&& CX_CONCAT(cx_unwrapped_, __LINE__) = (result);               \
+  if (CX_UNLIKELY(!CX_CONCAT(cx_unwrapped_, __LINE__)))               \
+    CX_RETURN(std::move(CX_CONCAT(cx_unwrapped_, __LINE__)).Forward()); \
+  declaration = std::move(CX_CONCAT(cx_unwrapped_, __LINE__)).Value()
+
+
+#endif  // CX_RESULT_HPP
@@ -0,0 +1,78 @@
+// vim: set tabstop=2 softtabstop=2 shiftwidth=2 expandtab :
+/*
+ * Copyright (c) 2026, Ryan V. Bissell
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ * See the enclosed "LICENSE" file for exact license terms.
+ */
+
+#ifndef CX_THROWSTATS_HPP
+#define CX_THROWSTATS_HPP
+
+// NOTE: this header is pulled into cx-exceptions.hpp when
+// CX_OPT_THROWSTATS is set, so keep it free of templates
+// and of heavyweight standard headers.
+
+#include <atomic>
+#include <stdio.h>
+
+#include "cx-types.hpp"
+#include "cx-hackery.hpp"
+
+namespace CX {
+namespace ThrowStats {
+
+  // counts are kept in a few cache-line sized shards per site, and
+  // each thread always bumps the same one; so threads throwing from
+  // the same site rarely share a line, and never share a lock.
+  enum { SHARDS = 8 };
+
+  struct alignas(64) Shard
+  {
+    std::atomic<U64> count{0};
+  };
+
+  // one per CX_THROW, as a function-local static.  It is linked
+  // into the registry by the first throw from that site.
+  struct Site
+  {
+    char const* where;    // file:line
+    char const* method;   // __PRETTY_FUNCTION__ of the thrower
+    char const* type;     // exception type, as spelled at the site
+    char const* what;     // its 'what' code, likewise
+
+    std::atomic<U64> first{0};  // steady-clock ns of the first throw
+    Site* next = nullptr;
+    Shard shards[SHARDS] = {};
+  };
+
+  void enroll(Site& site) CX_COLD;
+  unsigned get_shard();
+
+  inline void count(Site& site)
+  {
+    if (CX_UNLIKELY(site.first.load(std::memory_order_relaxed) == 0))
+      enroll(site);
+    site.shards[get_shard()].count.fetch_add(1,
+                                             std::memory_order_relaxed);
+  }
+
+  // every site that has thrown, most recently enrolled first
+  Site const* get_sites();
+  U64 get_count(Site const& site);
+
+  // throws per second, from the site's first throw until now
+  double get_rate(Site const& site);
+
+  void reset();
+
+  // writes one line per site, most frequent first.  If CX_THROWSTATS
+  // names a file (or is '-', for stderr) this also happens
+  // automatically at exit.
+  void report(FILE* file);
+
+} // namespace 'ThrowStats'
+} // namespace 'CX'
+
+#endif // CX_THROWSTATS_HPP
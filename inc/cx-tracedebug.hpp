@@ -19,9 +19,19 @@ extern "C" {
 #include <string.h>
 
 #include "cx-types.hpp"
+#include "cx-hackery.hpp"
 
 namespace CX
 {
+  // static, per-callsite description of a CX_ASSERT
+  struct AssertSite
+  {
+    char const* expr;
+    char const* function;
+    char const* file;
+    int line;
+  };
+
   bool is_enabled();
 
   U64 get_tracelevel();
@@ -35,6 +45,27 @@ namespace CX
   void set_errorfile(FILE *file);
   void flush();
 
+  // as it's destroyed (at exit, for a static), calls 'report' with
+  // the file named by the environment variable 'envvar', or stderr
+  // if that is '-'; or does nothing, if it's unset.  for the stats
+  // components' reports.
+  class ExitReport
+  {
+  public:
+    typedef void (*Report)(FILE* file);
+
+    ExitReport(char const* envvar, Report report)
+      : envvar_(envvar), report_(report)
+    {
+    }
+
+    ~ExitReport();
+
+  private:
+    char const* envvar_;
+    Report report_;
+  };
+
   void debugout(char const* format, ...);
   void warning(bool test, char const* format, ...);
   void topicout(char const* topic, char const* format, ...);
@@ -48,6 +79,10 @@ namespace CX
 #endif
 
   char const* get_assert_message();
+  // 'format' is null when CX_ASSERT() was given no message
+  [[noreturn]] void assert_failed(AssertSite const* site,
+                                  char const* format = nullptr, ...)
+                                  CX_COLD CX_PRINTF(2, 3);
 
 } // namespace 'CX'
 
@@ -108,20 +143,16 @@ const U64 cx_traceflag=0;
 #define CX_BREAKPOINT
 #endif
 
+// everything but the test itself is out of line, in the cold
+// CX::assert_failed(), so that each use costs a single branch.  the
+// message is optional.
 #define CX_ASSERT(expr, format_and_args...)                           \
 {                                                                     \
-  if (!(expr))                                                        \
+  if (CX_UNLIKELY(!(expr)))                                           \
   {                                                                   \
-    CX_ERROROUT("\n!!! %s\n\n", CX::get_assert_message());            \
-    CX_ERROROUT("    What:  assertion / debugger-trap\n");            \
-    CX_ERROROUT("    Why:   " format_and_args);                       \
-    CX_ERROROUT("\n");                                                \
-    CX_ERROROUT("    How:   '%s'\n", #expr);                          \
-    CX_ERROROUT("    Who:   '%s'\n", __PRETTY_FUNCTION__);            \
-    CX_ERROROUT("    Where: '%s', line %d\n", __FILE__, __LINE__);    \
-    CX::flush();                                                      \
-    CX_BREAKPOINT;                                                    \
-    abort();                                                          \
+    static CX::AssertSite const cx_assertsite =                       \
+      { #expr, __PRETTY_FUNCTION__, __FILE__, __LINE__ };             \
+    CX::assert_failed(&cx_assertsite, ##format_and_args);             \
   }                                                                   \
 }
 
@@ -139,7 +170,10 @@ const U64 cx_traceflag=0;
 #if CX_OPT_TRACING
   #define CX_TRACEOUT(format_and_args...)                             \
     {                                                                 \
-      CX::traceout(CX_TRACE_SECTION, format_and_args);                \
+      if (CX_UNLIKELY(CX::detail::trace_state.load(                   \
+                        std::memory_order_relaxed) !=                 \
+                      CX::detail::TRACEOFF))                          \
+        CX::traceout(CX_TRACE_SECTION, format_and_args);              \
     }
 #else
   #define CX_TRACEOUT(format_and_args...)
@@ -171,14 +205,28 @@ const U64 cx_traceflag=0;
 #endif
 
 
+#if CX_OPT_PERFCOUNTERS
+  // profiling builds count hardware events across every traced
+  // scope; see cx-perfcounters.hpp
+  #define CX_PERF_PROLOGUE(name)                                      \
+      CX::Perf::Scope cx_perfscope(name);
+#else
+  #define CX_PERF_PROLOGUE(name)
+#endif
+
+
 extern char const* cx_trace_methodname;
 #if CX_OPT_TRACING
   #define CX_TRACE_PROLOGUE(name, args, decl)                         \
+      CX_PERF_PROLOGUE(name)                                          \
       CX_TRACE_STACK                                                  \
       char const* cx_trace_methodname = name;                         \
-      CX_TRACE_SHIFTIN(">" name "(" args ") " decl "\n");
+      static CX::TraceSite const cx_tracesite =                       \
+        { CX_TRACE_SECTION, ">" name "(" args ") " decl "\n" };       \
+      CX::TraceScope cx_tracescope(&cx_tracesite);
 #else
-  #define CX_TRACE_PROLOGUE(name, args, decl)
+  #define CX_TRACE_PROLOGUE(name, args, decl)                         \
+      CX_PERF_PROLOGUE(name)
 #endif
 
 #define CX_DECLMETHOD(object_method, declarator, ...)                 \
@@ -236,31 +284,30 @@ extern char const* cx_trace_methodname;
     CX_TRACE_PROLOGUE(#dtorname, #__VA_ARGS__,)
 
 
+// when tracing, the trace epilogue is the destructor of the
+// 'cx_tracescope' built by the prologue.  So these can hand their
+// expression straight to 'return', which keeps guaranteed copy
+// elision (and implicit moves of locals) intact.
 #if CX_OPT_TRACING
   #define CX_RETURNVOID                                               \
           do {                                                        \
             CX_DIV0ASSERT(cx_traceflag);                              \
-            CX_TRACE_SHIFTOUT("<\n");                                 \
-            CX::flush();                                              \
+            cx_tracescope.Returning();                                \
             return;                                                   \
           } while(0)
 
   #define CX_RETURNREF(...)                                           \
           do {                                                        \
             CX_DIV0ASSERT(cx_traceflag);                              \
-            auto& foo =  __VA_ARGS__;                                 \
-            CX_TRACE_SHIFTOUT("<\n");                                 \
-            CX::flush();                                              \
-            return foo;                                               \
+            cx_tracescope.Returning();                                \
+            return __VA_ARGS__;                                       \
           } while(0)
 
   #define CX_RETURN(...)                                              \
           do {                                                        \
             CX_DIV0ASSERT(cx_traceflag);                              \
-            auto foo =  __VA_ARGS__;                                  \
-            CX_TRACE_SHIFTOUT("<\n");                                 \
-            CX::flush();                                              \
-            return foo;                                               \
+            cx_tracescope.Returning();                                \
+            return __VA_ARGS__;                                       \
           } while(0)
 #else
   #define CX_RETURNVOID return
@@ -271,7 +318,6 @@ extern char const* cx_trace_methodname;
 #if CX_OPT_TRACING
   #define CX_ENDMETHOD                                                \
             CX_DIV0ASSERT(cx_traceflag);                              \
-            CX_TRACE_SHIFTOUT("<\n");                                 \
           }
 #else
   #define CX_ENDMETHOD }
@@ -286,28 +332,148 @@ extern char const* cx_trace_methodname;
 #endif
 
 #ifdef __cplusplus
+#if CX_OPT_PERFCOUNTERS
+#include "cx-perfcounters.hpp"
+#endif
+
+#if CX_OPT_TRACING
+#include <atomic>
+
+namespace CX
+{
+  // static, per-callsite description of a traced scope
+  struct TraceSite
+  {
+    char const* section;
+    char const* entry;    // the '>' line
+  };
+
+  namespace detail
+  {
+    // TRACEOFF once we know that no trace section can be active
+    // (no CX_TRACE, or CX output disabled.)  Until the first traced
+    // scope asks, it is TRACEUNKNOWN.  any thread may read or write
+    // it, but only relaxed; it's a cache, of what is always the same.
+    enum: U8 { TRACEUNKNOWN, TRACEOFF, TRACEON };
+    extern std::atomic<U8> trace_state;
+  }
+
+  // the trace epilogue is this object's destructor.  When tracing
+  // is off, entry and exit cost one predicted branch each; all the
+  // real work happens out of line, in enter() and leave().
+  class TraceScope
+  {
+  public:
+    explicit TraceScope(TraceSite const* site)
+      : site_(site), active_(false), returning_(false)
+    {
+      if (CX_UNLIKELY(detail::trace_state.load(std::memory_order_relaxed)
+                      != detail::TRACEOFF))
+        active_ = enter();
+    }
+
+    ~TraceScope()
+    {
+      if (CX_UNLIKELY(active_))
+        leave();
+    }
+
+    void Returning() { returning_ = true; }
+
+    TraceScope(TraceScope const&) = delete;
+    TraceScope& operator=(TraceScope const&) = delete;
+
+  private:
+    bool enter() CX_COLD;
+    void leave() CX_COLD;
+
+    TraceSite const* site_;
+    bool active_;
+    bool returning_;    // CX_RETURN flushes, falling off the end doesn't
+    int uncaught_;
+  };
+}
+#endif
+
 #include <string>
+#include <string_view>
+#if defined(__clang__) || defined(__GNUG__)
+  #define CX_TYPENAME_CONSTEXPR constexpr
+#else
+  #define CX_TYPENAME_CONSTEXPR
+#endif
 namespace CX
 {
+  // T's name as the compiler spells it, without any runtime cost
+  // (constexpr, where CX_TYPENAME_CONSTEXPR is.)  Not NUL-terminated.
+  template <typename T>
+  CX_TYPENAME_CONSTEXPR std::string_view get_typename_view();
+
+  // the same, as a std::string that is built once per type;
+  // repeated calls neither demangle nor allocate.
   template <typename T>
-  std::string get_typename();
+  std::string const& get_typename();
 }
 
-#include <string>
 #include <typeinfo>
 #include <cxxabi.h>
+namespace CX
+{
+  namespace detail
+  {
+    template<typename T>
+    std::string demangle_typename()
+    {
+      std::string tname = typeid(T).name();
+#if defined(__clang__) || defined(__GNUG__)
+      int status;
+      char *demangled_name = abi::__cxa_demangle(tname.c_str(),
+                                                 NULL, NULL, &status);
+      if (!status)
+      {
+        tname = demangled_name;
+        std::free(demangled_name);
+      }
+#endif
+      return tname;
+    }
+
+#if defined(__clang__) || defined(__GNUG__)
+    template<typename T>
+    constexpr std::string_view pretty_typename()
+    {
+      // g++:     "... pretty_typename() [with T = Foo; ...]"
+      // clang++: "... pretty_typename() [T = Foo]"
+      std::string_view pretty = __PRETTY_FUNCTION__;
+      std::string_view::size_type begin = pretty.find("T = ") + 4;
+      std::string_view::size_type end = pretty.find(';', begin);
+      if (end == std::string_view::npos)
+        end = pretty.rfind(']');
+      return pretty.substr(begin, end - begin);
+    }
+#endif
+  } // namespace 'detail'
+} // namespace 'CX'
+
+
 template<typename T>
-std::string CX::get_typename()
+CX_TYPENAME_CONSTEXPR std::string_view CX::get_typename_view()
 {
-  std::string tname = typeid(T).name();
 #if defined(__clang__) || defined(__GNUG__)
-  int status;
-  char *demangled_name = abi::__cxa_demangle(tname.c_str(), NULL, NULL, &status);
-  if (!status)
-  {
-    tname = demangled_name;
-    std::free(demangled_name);
-  }
+  return detail::pretty_typename<T>();
+#else
+  return get_typename<T>();
+#endif
+}
+
+
+template<typename T>
+std::string const& CX::get_typename()
+{
+#if defined(__clang__) || defined(__GNUG__)
+  static std::string const tname(detail::pretty_typename<T>());
+#else
+  static std::string const tname = detail::demangle_typename<T>();
 #endif
   return tname;
 }
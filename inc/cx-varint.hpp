@@ -0,0 +1,192 @@
+// vim: set tabstop=2 softtabstop=2 shiftwidth=2 expandtab :
+/*
+ * Copyright (c) 2026, Ryan V. Bissell
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ * See the enclosed "LICENSE" file for exact license terms.
+ */
+
+#ifndef CX_VARINT_HPP
+#define CX_VARINT_HPP
+
+// Variable-length integers, as LEB128: seven bits per byte, least
+// significant first, with the high bit set on every byte but the
+// last.  Signed integers are zigzagged first (0, -1, 1, -2... become
+// 0, 1, 2, 3...), so that small negative numbers stay short.
+//
+// Single values are encoded and decoded inline (and constexpr); whole
+// arrays are decoded with SIMD where the CPU has it (see
+// src/cx-varint.cpp), many values per instruction.
+//
+// Decoding accepts redundant encodings (e.g. 0x80 0x00, for zero),
+// but never more than MAXBYTES<T>, nor bits beyond T's.
+
+#include <stddef.h>
+
+#include <type_traits>
+
+#include "cx-types.hpp"
+#include "cx-hackery.hpp"
+#include "cx-endian.hpp"
+
+namespace CX {
+namespace Varint {
+
+  namespace detail
+  {
+    template <typename T, typename R = T>
+    using Integer = std::enable_if_t<std::is_integral<T>::value, R>;
+
+    // of type 'R', if 'T' is one of the integers with bulk kernels
+    template <typename T, typename R = T>
+    using Wide = std::enable_if_t<std::is_integral<T>::value &&
+                                  (sizeof(T) >= 2), R>;
+  }
+
+  // the longest encoding of a T
+  template <typename T>
+  constexpr size_t MAXBYTES = ((sizeof(T) * 8) + 6) / 7;
+
+
+  template <typename T>
+  constexpr detail::Integer<T, std::make_unsigned_t<T>> zigzag(T value)
+  {
+    typedef std::make_unsigned_t<T> U;
+    U const sign = static_cast<U>(static_cast<U>(value) >>
+                                  ((sizeof(T) * 8) - 1));
+    return static_cast<U>(static_cast<U>(static_cast<U>(value) << 1) ^
+                          static_cast<U>(0 - sign));
+  }
+
+  template <typename T>
+  constexpr detail::Integer<T> unzigzag(std::make_unsigned_t<T> value)
+  {
+    typedef std::make_unsigned_t<T> U;
+    return static_cast<T>(static_cast<U>(value >> 1) ^
+                          static_cast<U>(0 - (value & 1)));
+  }
+
+
+  // how many bytes encode() will write
+  template <typename T>
+  constexpr detail::Integer<T, size_t> encoded_size(T value)
+  {
+    typedef std::make_unsigned_t<T> U;
+    U bits = std::is_signed<T>::value ? zigzag(value) : value;
+
+    size_t size = 1;
+    for (; bits >= 0x80; bits >>= 7)
+      ++size;
+    return size;
+  }
+
+  // writes at most MAXBYTES<T>, and returns how many
+  template <typename T>
+  constexpr detail::Integer<T, size_t> encode(U8* out, T value)
+  {
+    typedef std::make_unsigned_t<T> U;
+    U bits = std::is_signed<T>::value ? zigzag(value) : value;
+
+    size_t size = 0;
+    for (; bits >= 0x80; bits >>= 7)
+      out[size++] = static_cast<U8>(bits | 0x80);
+    out[size++] = static_cast<U8>(bits);
+    return size;
+  }
+
+  // reads at most 'size' bytes, and returns how many; or 0, if they
+  // don't begin with a varint that fits in a T (either it's malformed,
+  // or it's cut short by the end of 'in'.  if MAXBYTES<T> were there,
+  // it's malformed.)
+  template <typename T>
+  constexpr detail::Integer<T, size_t> decode(T& value, U8 const* in,
+                                              size_t size)
+  {
+    typedef std::make_unsigned_t<T> U;
+    constexpr size_t LAST = MAXBYTES<T> - 1;
+
+    U bits = 0;
+    size_t const limit = (size < MAXBYTES<T>) ? size : MAXBYTES<T>;
+    for (size_t i = 0; i < limit; ++i)
+    {
+      U8 const byte = in[i];
+
+      // no more continuing, and no more bits than T has
+      if ((i == LAST) && (byte >> ((sizeof(T) * 8) - (7 * LAST))))
+        return 0;
+
+      bits |= static_cast<U>(static_cast<U>(byte & 0x7f) << (7 * i));
+      if (CX_LIKELY(!(byte & 0x80)))
+      {
+        if constexpr (std::is_signed<T>::value)
+          value = unzigzag<T>(bits);
+        else
+          value = bits;
+        return i + 1;
+      }
+    }
+    return 0;
+  }
+
+
+  // Whole arrays at once.  'out' needs room for count * MAXBYTES<T>.
+  template <typename T>
+  detail::Integer<T, size_t> encode(U8* out, T const* in, size_t count)
+  {
+    size_t size = 0;
+    for (size_t i = 0; i < count; ++i)
+      size += encode(out + size, in[i]);
+    return size;
+  }
+
+  // what decode() got through
+  struct Decoded
+  {
+    size_t count;   // values decoded
+    size_t bytes;   // and the bytes they took
+  };
+
+  // the same kernels as CX::Endian's; but only SCALAR and SSSE3 are
+  // had here (wider vectors buy nothing, since the varints' bytes are
+  // sorted into place 16 at a time.)
+  Endian::Kernel get_kernel();
+  bool set_kernel(Endian::Kernel kernel);
+
+  namespace detail
+  {
+    Decoded decode16(U16* out, size_t count, U8 const* in, size_t size);
+    Decoded decode32(U32* out, size_t count, U8 const* in, size_t size);
+    Decoded decode64(U64* out, size_t count, U8 const* in, size_t size);
+  }
+
+  // decodes up to 'count' values; fewer, when the bytes run out, or
+  // on reaching one that decode() would refuse (which is then the
+  // next, at 'in + bytes'.)
+  template <typename T>
+  detail::Wide<T, Decoded> decode(T* out, size_t count, U8 const* in,
+                                  size_t size)
+  {
+    typedef std::make_unsigned_t<T> U;
+    U* const bits = reinterpret_cast<U*>(out);
+
+    Decoded decoded;
+    if constexpr (sizeof(T) == 2)
+      decoded = detail::decode16(bits, count, in, size);
+    else if constexpr (sizeof(T) == 4)
+      decoded = detail::decode32(bits, count, in, size);
+    else
+      decoded = detail::decode64(bits, count, in, size);
+
+    if constexpr (std::is_signed<T>::value)
+    {
+      for (size_t i = 0; i < decoded.count; ++i)
+        out[i] = unzigzag<T>(bits[i]);
+    }
+    return decoded;
+  }
+
+} // namespace 'Varint'
+} // namespace 'CX'
+
+#endif  // CX_VARINT_HPP
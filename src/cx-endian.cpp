@@ -11,24 +11,265 @@
 
 #include "cx-endian.hpp"
 
+#include <stdint.h>
+
+#ifdef CX_ENDIAN_X86
+  #include <immintrin.h>
+#endif
 
 using namespace CX::Endian;
 
-template<>
-U16 detail::bswap<U16>(U16 val) { return CX_BSWAP16(val); }
 
-template<>
-S16 detail::bswap<S16>(S16 val) { return CX_BSWAP16((U16)val); }
+namespace
+{
+  // one function per element width, for the kernel in use
+  struct Kernels
+  {
+    Kernel kernel;
+    void (*swap16)(U8* out, U8 const* in, size_t count);
+    void (*swap32)(U8* out, U8 const* in, size_t count);
+    void (*swap64)(U8* out, U8 const* in, size_t count);
+  };
+
+
+  // by bytes, since nothing need be aligned
+  template <size_t WIDTH>
+  void _swap_scalar(U8* out, U8 const* in, size_t count)
+  {
+    typedef std::conditional_t<(WIDTH == 2), U16,
+              std::conditional_t<(WIDTH == 4), U32, U64>> U;
+
+    for (size_t i = 0; i < count; ++i)
+    {
+      U value;
+      memcpy(&value, in + (i * WIDTH), WIDTH);
+      value = detail::bswap(value);
+      memcpy(out + (i * WIDTH), &value, WIDTH);
+    }
+  }
+
+
+  // how many elements to do one at a time, so that the vector stores
+  // that follow are aligned (when 'out' is aligned to its elements,
+  // anyway; otherwise, none.)
+  template <size_t WIDTH, size_t VECTOR>
+  size_t _head(U8 const* out, size_t count)
+  {
+    size_t bytes = (0 - reinterpret_cast<uintptr_t>(out)) & (VECTOR - 1);
+    size_t head = (bytes % WIDTH) ? 0 : (bytes / WIDTH);
+    return (head < count) ? head : count;
+  }
+
+
+#ifdef CX_ENDIAN_X86
+  // pshufb indices reversing each WIDTH bytes, for 64 bytes (so, for
+  // every vector size); the same in every 16-byte lane.
+  template <size_t WIDTH>
+  struct Mask
+  {
+    alignas(64) U8 bytes[64];
+
+    constexpr Mask() : bytes{}
+    {
+      for (size_t i = 0; i < 64; ++i)
+        bytes[i] = static_cast<U8>(((i % 16) / WIDTH) * WIDTH +
+                                   (WIDTH - 1 - (i % WIDTH)));
+    }
+  };
+
+  template <size_t WIDTH>
+  constexpr Mask<WIDTH> g_mask{};
+
+
+  template <size_t WIDTH>
+  CX_TARGET("ssse3")
+  void _swap_ssse3(U8* out, U8 const* in, size_t count)
+  {
+    size_t head = _head<WIDTH, 16>(out, count);
+    _swap_scalar<WIDTH>(out, in, head);
+
+    U8 const* const shuffle = g_mask<WIDTH>.bytes;
+    __m128i const mask =
+      _mm_load_si128(reinterpret_cast<__m128i const*>(shuffle));
+    size_t const bytes = count * WIDTH;
+    size_t i = head * WIDTH;
+    for (; (i + 16) <= bytes; i += 16)
+    {
+      __m128i v = _mm_loadu_si128(reinterpret_cast<__m128i const*>(in + i));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i),
+                       _mm_shuffle_epi8(v, mask));
+    }
+
+    _swap_scalar<WIDTH>(out + i, in + i, (bytes - i) / WIDTH);
+  }
+
+
+  template <size_t WIDTH>
+  CX_TARGET("avx2")
+  void _swap_avx2(U8* out, U8 const* in, size_t count)
+  {
+    size_t head = _head<WIDTH, 32>(out, count);
+    _swap_scalar<WIDTH>(out, in, head);
+
+    U8 const* const shuffle = g_mask<WIDTH>.bytes;
+    __m256i const mask =
+      _mm256_load_si256(reinterpret_cast<__m256i const*>(shuffle));
+    size_t const bytes = count * WIDTH;
+    size_t i = head * WIDTH;
+
+    // two at a time, since each is only a load, a shuffle and a store
+    for (; (i + 64) <= bytes; i += 64)
+    {
+      __m256i v0 = _mm256_loadu_si256(
+                     reinterpret_cast<__m256i const*>(in + i));
+      __m256i v1 = _mm256_loadu_si256(
+                     reinterpret_cast<__m256i const*>(in + i + 32));
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i),
+                          _mm256_shuffle_epi8(v0, mask));
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i + 32),
+                          _mm256_shuffle_epi8(v1, mask));
+    }
+    if ((i + 32) <= bytes)
+    {
+      __m256i v = _mm256_loadu_si256(
+                    reinterpret_cast<__m256i const*>(in + i));
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i),
+                          _mm256_shuffle_epi8(v, mask));
+      i += 32;
+    }
+
+    // fewer than 32 bytes remain
+    _swap_ssse3<WIDTH>(out + i, in + i, (bytes - i) / WIDTH);
+  }
+
+
+  template <size_t WIDTH>
+  CX_TARGET("avx512f,avx512bw")
+  void _swap_avx512(U8* out, U8 const* in, size_t count)
+  {
+    __m512i const mask = _mm512_load_si512(g_mask<WIDTH>.bytes);
+    size_t const bytes = count * WIDTH;
+    size_t i = 0;
+
+    // the head and the tail are done with masked loads and stores,
+    // rather than one element at a time
+    size_t head = _head<WIDTH, 64>(out, count) * WIDTH;
+    if (head)
+    {
+      __mmask64 lanes = (~0ULL) >> (64 - head);
+      __m512i v = _mm512_maskz_loadu_epi8(lanes, in);
+      _mm512_mask_storeu_epi8(out, lanes, _mm512_shuffle_epi8(v, mask));
+      i = head;
+    }
+
+    for (; (i + 128) <= bytes; i += 128)
+    {
+      __m512i v0 = _mm512_loadu_si512(in + i);
+      __m512i v1 = _mm512_loadu_si512(in + i + 64);
+      _mm512_storeu_si512(out + i, _mm512_shuffle_epi8(v0, mask));
+      _mm512_storeu_si512(out + i + 64, _mm512_shuffle_epi8(v1, mask));
+    }
+    for (; i < bytes; i += 64)
+    {
+      size_t left = bytes - i;
+      __mmask64 lanes = (left >= 64) ? ~0ULL : ((~0ULL) >> (64 - left));
+      __m512i v = _mm512_maskz_loadu_epi8(lanes, in + i);
+      _mm512_mask_storeu_epi8(out + i, lanes,
+                              _mm512_shuffle_epi8(v, mask));
+    }
+  }
+#endif
+
+
+  #define CX_KERNELS(kernel, fn)                                      \
+    { Kernel::kernel, &fn<2>, &fn<4>, &fn<8> }
+
+  Kernels const g_kernels[] =
+  {
+    CX_KERNELS(SCALAR, _swap_scalar),
+#ifdef CX_ENDIAN_X86
+    CX_KERNELS(SSSE3, _swap_ssse3),
+    CX_KERNELS(AVX2, _swap_avx2),
+    CX_KERNELS(AVX512, _swap_avx512),
+#endif
+  };
+
+  #undef CX_KERNELS
+
+
+  KernelTable g_table(g_kernels);
+}
+
+
+bool
+CX::Endian::supported(Kernel kernel)
+{
+  switch (kernel)
+  {
+    case Kernel::SCALAR:
+      return true;
+#ifdef CX_ENDIAN_X86
+    case Kernel::SSSE3:
+      return __builtin_cpu_supports("ssse3");
+    case Kernel::AVX2:
+      return __builtin_cpu_supports("avx2");
+    case Kernel::AVX512:
+      return __builtin_cpu_supports("avx512f") &&
+             __builtin_cpu_supports("avx512bw");
+#endif
+    default:
+      return false;
+  }
+}
+
+
+Kernel
+CX::Endian::get_kernel()
+{
+  return g_table.Active().kernel;
+}
+
+
+bool
+CX::Endian::set_kernel(Kernel kernel)
+{
+  return g_table.Select(kernel);
+}
+
+
+char const*
+CX::Endian::kernel_name(Kernel kernel)
+{
+  switch (kernel)
+  {
+    case Kernel::SCALAR:  return "SCALAR";
+    case Kernel::SSSE3:   return "SSSE3";
+    case Kernel::AVX2:    return "AVX2";
+    case Kernel::AVX512:  return "AVX512";
+  }
+  return "?";
+}
+
 
-template<>
-U32 detail::bswap<U32>(U32 val) { return CX_BSWAP32(val); }
+void
+CX::Endian::detail::bswap16(void* out, void const* in, size_t count)
+{
+  g_table.Active().swap16(static_cast<U8*>(out), static_cast<U8 const*>(in),
+                   count);
+}
 
-template<>
-S32 detail::bswap<S32>(S32 val) { return CX_BSWAP32((U32)val); }
 
-template<>
-U64 detail::bswap<U64>(U64 val) { return CX_BSWAP64(val); }
+void
+CX::Endian::detail::bswap32(void* out, void const* in, size_t count)
+{
+  g_table.Active().swap32(static_cast<U8*>(out), static_cast<U8 const*>(in),
+                   count);
+}
 
-template<>
-S64 detail::bswap<S64>(S64 val) { return CX_BSWAP64((U64)val); }
 
+void
+CX::Endian::detail::bswap64(void* out, void const* in, size_t count)
+{
+  g_table.Active().swap64(static_cast<U8*>(out), static_cast<U8 const*>(in),
+                   count);
+}
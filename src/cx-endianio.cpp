@@ -0,0 +1,90 @@
+// vim: set tabstop=2 softtabstop=2 shiftwidth=2 expandtab :
+/*
+ * Copyright (c) 2026, Ryan V. Bissell
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ * See the enclosed "LICENSE" file for exact license terms.
+ */
+
+#define CX_TRACE_SECTION "endian"
+
+#include "cx-endianio.hpp"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <utility>
+
+using namespace CX;
+
+
+CX_FUNCTION(void CX::detail::bytes_overrun, size_t offset, size_t wanted,
+                                            size_t size)
+  CX_THROW(BytesException, BytesError::BOUNDS,
+           "%zu bytes at offset %zu, of %zu", wanted, offset, size);
+CX_ENDFUNCTION
+
+
+MappedFile::~MappedFile()
+{
+  if (data_)
+    munmap(data_, size_);
+}
+
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+  : data_(std::exchange(other.data_, nullptr)),
+    size_(std::exchange(other.size_, 0))
+{
+}
+
+
+MappedFile&
+MappedFile::operator=(MappedFile&& other) noexcept
+{
+  std::swap(data_, other.data_);
+  std::swap(size_, other.size_);
+  return *this;
+}
+
+
+CX_METHOD(MappedFileResult MappedFile::Open, char const* path)
+  int fd = open(path, O_RDONLY | O_CLOEXEC);
+  if (fd < 0)
+    CX_FAIL(BytesException, BytesError::MAP, "'%s': %s", path,
+            strerror(errno));
+
+  struct stat status;
+  if (fstat(fd, &status) < 0)
+  {
+    int error = errno;
+    close(fd);
+    CX_FAIL(BytesException, BytesError::MAP, "'%s': %s", path,
+            strerror(error));
+  }
+
+  // mmap(2) refuses empty mappings; but an empty file is no error
+  MappedFile mapped;
+  if (status.st_size > 0)
+  {
+    void* data = mmap(nullptr, status.st_size, PROT_READ, MAP_PRIVATE,
+                      fd, 0);
+    if (data == MAP_FAILED)
+    {
+      int error = errno;
+      close(fd);
+      CX_FAIL(BytesException, BytesError::MAP, "'%s': %s", path,
+              strerror(error));
+    }
+    mapped.data_ = data;
+    mapped.size_ = status.st_size;
+  }
+
+  // the mapping outlives the descriptor
+  close(fd);
+  CX_RETURN(MappedFileResult(std::move(mapped)));
+CX_ENDMETHOD
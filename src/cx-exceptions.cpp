@@ -7,10 +7,14 @@
  * See the enclosed "LICENSE" file for exact license terms.
  */
 
+#include <atomic>
+#include <new>
 #include <typeinfo>
 
 #include <stdio.h>
 #include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
 
 
 // this disables tracing for exceptions.
@@ -21,53 +25,100 @@
 
 
 char const * CX::thrown_message = "{{{ Exception thrown in '%s' }}}\n";
+char const * CX::failed_message = "{{{ Failure returned in '%s' }}}\n";
 char const * CX::caught_message = "{{{ Exception caught in '%s' }}}\n";
 char const * CX::trace_reset_message = "{{{ Tracing reset }}}\n";
 
-#define X(v,str) { CX::Error::v, "CXError::"#v },
-std::map<CX::Error, const char*> CX::ErrorNameMap =
-{
-  CX_EXCEPTIONS
-};
-#undef X
-
-#define X(v,str) { CX::Error::v, str },
-std::map<CX::Error, const char*> CX::ErrorStringMap =
-{
-  CX_EXCEPTIONS
-};
-#undef X
-
 
 CX::BaseException::BaseException( const char* who,
                                   const char* where,
                                   U32 what)
+                                  : _reason(nullptr)
 {
   _who = who;
   _what = what;
+  _where = where;
+
+  _reasonstate = NOREASON;
+  _formatter = nullptr;
+  _args[0] = '\x0';
+
+#ifdef CX_OPT_THROWSTACK
+  // start from whoever is constructing us
+  _stackdepth = 0;
+  if (!detail::t_nostack)
+    captureStack(__builtin_return_address(0));
+#endif
+}
+
+
+CX::BaseException::BaseException(BaseException const& other)
+                                  : _reason(nullptr)
+{
+  *this = other;
+}
+
+
+CX::BaseException&
+CX::BaseException::operator=(BaseException const& other)
+{
+  if (this != &other)
+  {
+    _who = other._who;
+    _what = other._what;
+    _where = other._where;
+
+    // the copy formats its own reason, if it is ever asked for
+    _reasonstate = other._reasonstate;
+    _formatter = other._formatter;
+    memcpy(_args, other._args, sizeof(_args));
+    delete[] _reason.exchange(nullptr);
+
+#ifdef CX_OPT_THROWSTACK
+    _stackdepth = other._stackdepth;
+    memcpy(_stack, other._stack, _stackdepth * sizeof(_stack[0]));
+#endif
+  }
+  return *this;
+}
 
-  SetWhere(where);
 
-  _reason = nullptr;
-  _reasonbuffer[0] = '\x0';
+CX::BaseException::~BaseException()
+{
+  delete[] _reason.load();
 }
 
 
-void CX::BaseException::SetWhere(const char* where)
+const char* CX::BaseException::Reason() const
 {
-  _where = nullptr;
-  _wherebuffer[0] = '\x0';
+  switch (_reasonstate)
+  {
+    case NOREASON:  return nullptr;
+    case EAGER:     return _args;
+  }
 
-  if (where)
+  char* reason = _reason.load(std::memory_order_acquire);
+  if (reason)
+    return reason;
+
+  char* buffer = new (std::nothrow) char[CX_EXCEPTIONSIZE];
+  if (!buffer)
   {
-    // strip off path to filename
-    const char* find = where + strlen(where);
-    do {
-      --find;
-    } while ((find >= where) && ((*find != '/') && (*find != '\\')));
-    _where = _wherebuffer;
-    strncpy(_wherebuffer, find+1, CX_EXCEPTIONSIZE-1);
+    // no memory for formatting; the bare format beats nothing
+    U16 format;
+    memcpy(&format, _args, sizeof(format));
+    return _args + format;
   }
+
+  _formatter(buffer, CX_EXCEPTIONSIZE, _args);
+  if (!_reason.compare_exchange_strong(reason, buffer,
+                                       std::memory_order_acq_rel))
+  {
+    // somebody else got there first
+    delete[] buffer;
+    return reason;
+  }
+  return buffer;
 }
 
 
@@ -75,10 +126,8 @@ void CX::BaseException::SetReason(const char* format, va_list pArgs)
 {
   if (format)
   {
-    vsnprintf(_reasonbuffer, CX_EXCEPTIONSIZE-1, format, pArgs);
-
-    _reason = _reasonbuffer;
-    _reasonbuffer[CX_EXCEPTIONSIZE-1] = '\x0';  // ...just in case
+    vsnprintf(_args, sizeof(_args), format, pArgs);
+    _reasonstate = EAGER;
   }
 }
 
@@ -104,6 +153,110 @@ static const char* CX::_malloc_demangled_name(onst char* name)
 #endif
 
 
+#ifdef CX_OPT_THROWSTACK
+#include <cxxabi.h>   // abi::__cxa_demangle()
+#include <dlfcn.h>    // dladdr()
+#include <unwind.h>   // _Unwind_Backtrace()
+
+namespace
+{
+  struct StackCapture
+  {
+    void** frames;
+    U32 depth;
+    U32 skipped;
+    void* start;    // first frame wanted, if we can find it
+  };
+
+  _Unwind_Reason_Code _capture_frame(_Unwind_Context* context, void* arg)
+  {
+    StackCapture* capture = static_cast<StackCapture*>(arg);
+    uintptr_t pc = _Unwind_GetIP(context);
+
+    // the frames of the capture itself vary with inlining and
+    // tail calls, so they're skipped by address, not by count
+    if (capture->start)
+    {
+      if ((reinterpret_cast<void*>(pc) != capture->start) &&
+          (++capture->skipped < 8))
+        return _URC_NO_REASON;
+      capture->start = nullptr;
+    }
+
+    if (!pc || (capture->depth >= CX_THROWSTACKDEPTH))
+      return _URC_END_OF_STACK;
+
+    capture->frames[capture->depth++] = reinterpret_cast<void*>(pc);
+    return _URC_NO_REASON;
+  }
+
+
+  // only runs when a stack is printed; so this is where we can
+  // afford dladdr() and demangling.
+  void _format_frame(U32 index, void* pc, char* out, size_t size)
+  {
+    // a return address may be just past the end of its caller,
+    // so look up the call instruction instead
+    Dl_info info;
+    char* address = static_cast<char*>(pc) - 1;
+    if (!dladdr(address, &info))
+    {
+      snprintf(out, size, "  #%-2u %p", index, pc);
+      return;
+    }
+
+    char const* module = info.dli_fname ? info.dli_fname : "?";
+    char const* slash = strrchr(module, '/');
+    module = slash ? slash + 1 : module;
+
+    if (!info.dli_sname)
+    {
+      snprintf(out, size, "  #%-2u %p  (%s+%#tx)", index, pc, module,
+               address + 1 - static_cast<char*>(info.dli_fbase));
+      return;
+    }
+
+    int status;
+    char* demangled = abi::__cxa_demangle(info.dli_sname,
+                                          nullptr, nullptr, &status);
+    snprintf(out, size, "  #%-2u %p  %s+%#tx  (%s)", index, pc,
+             demangled ? demangled : info.dli_sname,
+             address + 1 - static_cast<char*>(info.dli_saddr), module);
+    free(demangled);
+  }
+}
+
+
+thread_local U32 CX::detail::t_nostack = 0;
+
+
+void CX::BaseException::captureStack(void* start)
+{
+  StackCapture capture = { _stack, 0, 0, start };
+  _Unwind_Backtrace(_capture_frame, &capture);
+  _stackdepth = capture.depth;
+}
+
+
+void CX::BaseException::CaptureStack()
+{
+  if (!_stackdepth)
+    captureStack(__builtin_return_address(0));
+}
+
+
+void CX::BaseException::PrintStack(FILE* file) const
+{
+  for (U32 i = 0; i < _stackdepth; ++i)
+  {
+    char frame[512];
+    _format_frame(i, _stack[i], frame, sizeof(frame));
+    fprintf(file, "%s\n", frame);
+  }
+}
+#endif
+
+
 void CX::BaseException::StdError() const
 {
 #ifdef CX_DEMANGLE
@@ -117,8 +270,51 @@ void CX::BaseException::StdError() const
   CX_ERROROUT("Why:     '%s'\n", Why());
   CX_ERROROUT("Reason:  '%s'\n", Reason());
 
+#ifdef CX_OPT_THROWSTACK
+  if (_stackdepth)
+  {
+    CX_ERROROUT("Stack:\n");
+    for (U32 i = 0; i < _stackdepth; ++i)
+    {
+      char frame[512];
+      _format_frame(i, _stack[i], frame, sizeof(frame));
+      CX_ERROROUT("%s\n", frame);
+    }
+  }
+#endif
+
 #ifdef CX_DEMANGLE
   free(const_cast<char*>(name));
 #endif
 }
 
+
+
+#ifdef CX_OPT_NOEXCEPTIONS
+static void _default_throw_handler(CX::BaseException const& exception)
+{
+  exception.StdError();
+  CX::flush();
+  abort();
+}
+
+static std::atomic<CX::ThrowHandler> g_throw_handler(
+                                        _default_throw_handler);
+
+
+CX::ThrowHandler CX::set_throw_handler(ThrowHandler handler)
+{
+  if (!handler)
+    handler = _default_throw_handler;
+  return g_throw_handler.exchange(handler);
+}
+
+
+void CX::throw_unhandled(BaseException const& exception)
+{
+  g_throw_handler.load()(exception);
+
+  // handlers aren't supposed to return, but just in case
+  abort();
+}
+#endif
@@ -0,0 +1,165 @@
+// vim: set tabstop=2 softtabstop=2 shiftwidth=2 expandtab :
+/*
+ * Copyright (c) 2026, Ryan V. Bissell
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ * See the enclosed "LICENSE" file for exact license terms.
+ */
+
+#include "cx-factorystats.hpp"
+#include "cx-tracedebug.hpp"
+
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+
+using namespace CX::FactoryStats;
+
+
+namespace
+{
+  // products are only ever pushed, never removed; so walking the
+  // list needs no lock.
+  std::atomic<Product*> g_products(nullptr);
+  std::atomic<unsigned> g_nextshard(0);
+
+
+  U64 _live(Product const& product)
+  {
+    U64 created = 0, destroyed = 0;
+    for (auto const& shard : product.shards)
+    {
+      created += shard.created.load(std::memory_order_relaxed);
+      destroyed += shard.destroyed.load(std::memory_order_relaxed);
+    }
+
+    // shards are read one at a time, so a destruction may be seen
+    // without its creation
+    return (created > destroyed) ? (created - destroyed) : 0;
+  }
+
+
+  U64 _peak(Product const& product, U64 live)
+  {
+    std::atomic<U64>& peak = const_cast<Product&>(product).peak;
+    U64 seen = peak.load(std::memory_order_relaxed);
+    while ((live > seen) &&
+           !peak.compare_exchange_weak(seen, live,
+                                       std::memory_order_relaxed))
+      ;
+    return std::max(live, seen);
+  }
+}
+
+
+Product*
+CX::FactoryStats::enroll(std::string_view key, std::string_view type,
+                         size_t size)
+{
+  Product* product = new Product;
+  product->key = key;
+  product->type = type;
+  product->size = size;
+
+  Product* head = g_products.load(std::memory_order_relaxed);
+  do {
+    product->next = head;
+  } while (!g_products.compare_exchange_weak(head, product,
+                                             std::memory_order_release,
+                                             std::memory_order_relaxed));
+  return product;
+}
+
+
+unsigned
+CX::FactoryStats::next_shard()
+{
+  return g_nextshard.fetch_add(1, std::memory_order_relaxed) % SHARDS;
+}
+
+
+void
+CX::FactoryStats::sample(Product& product)
+{
+  _peak(product, _live(product));
+}
+
+
+Product const*
+CX::FactoryStats::get_products()
+{
+  return g_products.load(std::memory_order_acquire);
+}
+
+
+Counts
+CX::FactoryStats::get_counts(Product const& product)
+{
+  U64 created = 0;
+  for (auto const& shard : product.shards)
+    created += shard.created.load(std::memory_order_relaxed);
+
+  U64 live = _live(product);
+  U64 peak = _peak(product, live);
+  return { created, live, peak, live * product.size, peak * product.size };
+}
+
+
+void
+CX::FactoryStats::report(FILE* file)
+{
+  std::vector<Product const*> products;
+  for (Product const* product = get_products(); product;
+       product = product->next)
+    products.push_back(product);
+
+  report(file, std::move(products));
+}
+
+
+void
+CX::FactoryStats::report(FILE* file, std::vector<Product const*> products)
+{
+  if (!file)
+    return;
+
+  struct Row
+  {
+    Product const* product;
+    Counts counts;
+  };
+
+  std::vector<Row> rows;
+  for (Product const* product : products)
+    rows.push_back({ product, get_counts(*product) });
+
+  std::stable_sort(rows.begin(), rows.end(),
+                   [](Row const& a, Row const& b)
+                   {
+                     return a.counts.bytes > b.counts.bytes;
+                   });
+
+  fprintf(file, "%10s %10s %10s %12s %12s  %s\n",
+          "created", "live", "peak", "live-bytes", "peak-bytes",
+          "key (type)");
+  for (auto const& row : rows)
+  {
+    fprintf(file, "%10" PRIu64 " %10" PRIu64 " %10" PRIu64
+                  " %12" PRIu64 " %12" PRIu64 "  %s (%s)\n",
+            row.counts.created, row.counts.live, row.counts.peak,
+            row.counts.bytes, row.counts.peakbytes,
+            row.product->key.c_str(), row.product->type.c_str());
+  }
+
+  fflush(file);
+}
+
+
+namespace
+{
+  CX::ExitReport g_exitreport("CX_FACTORYSTATS",
+                              [](FILE* file) { report(file); });
+}
@@ -0,0 +1,568 @@
+// vim: set tabstop=2 softtabstop=2 shiftwidth=2 expandtab :
+/*
+ * Copyright (c) 2026, Ryan V. Bissell
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ * See the enclosed "LICENSE" file for exact license terms.
+ */
+
+#define CX_TRACE_SECTION "perf"
+
+#include "cx-perfcounters.hpp"
+#include "cx-tracedebug.hpp"
+
+#include <errno.h>
+#include <string.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#endif
+
+using namespace CX::Perf;
+
+
+namespace
+{
+  struct StrLess
+  {
+    bool operator()(char const* a, char const* b) const
+    {
+      return strcmp(a, b) < 0;
+    }
+  };
+
+  typedef std::map<char const*, Stats, StrLess> StatsMap;
+
+
+  void _accumulate(Stats& into, Stats const& from)
+  {
+    into.calls += from.calls;
+    for (int i = 0; i < SLOTS; ++i)
+      into.total.value[i] += from.total.value[i];
+  }
+
+
+  // what a thread accumulates per method.  Only the owning thread
+  // adds to these, but a reporting thread may read or zero them at
+  // any time, hence the (relaxed, uncontended) atomics.
+  struct Counters
+  {
+    std::atomic<U64> calls = { 0 };
+    std::atomic<U64> total[SLOTS] = {};
+  };
+
+
+  // one of these per thread.  'lock_' only guards the shape of
+  // 'stats_', so the owning thread takes it just the first time it
+  // sees a method; after that 'cache_' finds the counters directly.
+  class ThreadGroup
+  {
+  public:
+    ThreadGroup();
+    ~ThreadGroup();
+
+    enum { CACHED = 64 };   // power of two
+
+    Source source() const { return source_; }
+    void read(Sample& sample);
+    void record(char const* method, Sample const& delta);
+    void collect(StatsMap& into);
+    void clear();
+
+  private:
+    bool openPerf(Source source);
+    void closePerf();
+    Counters& lookup(char const* method);
+
+    Source source_;
+    int fds_[SLOTS];
+    int index_[SLOTS];    // position of each slot in a group read
+    int nr_;
+
+    std::mutex lock_;
+    std::unordered_map<char const*, Counters> stats_;
+
+    // owner-only; elements of an unordered_map never move
+    struct Cached
+    {
+      char const* method;
+      Counters* counters;
+    } cache_[CACHED];
+  };
+
+
+  // process-wide bookkeeping.  Deliberately leaked, so that it
+  // outlives every thread_local ThreadGroup and the exit-time report.
+  struct Registry
+  {
+    std::mutex lock;
+    std::vector<ThreadGroup*> live;
+    StatsMap retired;         // totals from threads that have exited
+    Source source = Source::NONE;
+    U32 unmeasured = 0;       // threads that couldn't open 'source'
+  };
+
+  Registry& _registry()
+  {
+    static Registry* registry = new Registry;
+    return *registry;
+  }
+
+
+  thread_local ThreadGroup* t_group = nullptr;
+  thread_local bool t_retired = false;
+
+  struct ThreadGroupOwner
+  {
+    ~ThreadGroupOwner()
+    {
+      delete t_group;
+      t_group = nullptr;
+      t_retired = true;
+    }
+  };
+  thread_local ThreadGroupOwner t_owner;
+
+
+  ThreadGroup* _get_group()
+  {
+    if (!t_group && !t_retired)
+    {
+      (void)&t_owner;   // odr-use, so its destructor is registered
+      t_group = new ThreadGroup;
+    }
+    return t_group;
+  }
+
+
+  Source _parse_source(char const* text)
+  {
+    if (text)
+    {
+      if (!strcmp(text, "hardware")) return Source::HARDWARE;
+      if (!strcmp(text, "software")) return Source::SOFTWARE;
+      if (!strcmp(text, "clock"))    return Source::CLOCK;
+    }
+    return Source::HARDWARE;
+  }
+
+
+  char const* _source_name(Source source)
+  {
+    static char const* const names[] =
+      { "none", "hardware", "software", "clock" };
+    return names[static_cast<U32>(source)];
+  }
+
+
+#ifdef __linux__
+  int _perf_event_open(U32 type, U64 config, int group)
+  {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.read_format = PERF_FORMAT_GROUP;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.disabled = (group == -1);
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, group, 0);
+  }
+#endif
+} // namespace
+
+
+ThreadGroup::ThreadGroup() : source_(Source::NONE), nr_(0)
+{
+  for (int i = 0; i < SLOTS; ++i)
+    fds_[i] = index_[i] = -1;
+  for (int i = 0; i < CACHED; ++i)
+    cache_[i] = { nullptr, nullptr };
+
+  Registry& registry = _registry();
+  std::lock_guard<std::mutex> guard(registry.lock);
+
+  // the first thread in decides the source for the whole process,
+  // so that the units being aggregated per method always agree.
+  if (registry.source == Source::NONE)
+  {
+    Source want = _parse_source(getenv("CX_PERFSOURCE"));
+
+    if ((want == Source::HARDWARE) && openPerf(Source::HARDWARE))
+      registry.source = Source::HARDWARE;
+    else if ((want != Source::CLOCK) && openPerf(Source::SOFTWARE))
+      registry.source = Source::SOFTWARE;
+    else
+      registry.source = Source::CLOCK;
+
+    source_ = registry.source;
+  }
+  else if ((registry.source == Source::CLOCK)
+        || openPerf(registry.source))
+  {
+    source_ = registry.source;
+  }
+  else
+  {
+    // rather than mix in some other unit, this thread goes uncounted
+    registry.unmeasured++;
+  }
+
+  registry.live.push_back(this);
+}
+
+
+ThreadGroup::~ThreadGroup()
+{
+  Registry& registry = _registry();
+  std::lock_guard<std::mutex> guard(registry.lock);
+
+  collect(registry.retired);
+  registry.live.erase(std::find(registry.live.begin(),
+                                registry.live.end(), this));
+  closePerf();
+}
+
+
+bool ThreadGroup::openPerf(Source source)
+{
+#ifdef __linux__
+  static U64 const hardware[SLOTS] =
+  {
+    PERF_COUNT_HW_CPU_CYCLES,
+    PERF_COUNT_HW_INSTRUCTIONS,
+    PERF_COUNT_HW_CACHE_MISSES,   // last-level cache, on most PMUs
+    PERF_COUNT_HW_BRANCH_MISSES,
+  };
+  static U64 const software[SLOTS] =
+  {
+    PERF_COUNT_SW_TASK_CLOCK,
+    PERF_COUNT_SW_CONTEXT_SWITCHES,
+    PERF_COUNT_SW_PAGE_FAULTS,
+    PERF_COUNT_SW_CPU_MIGRATIONS,
+  };
+
+  U32 type = (source == Source::HARDWARE) ? PERF_TYPE_HARDWARE
+                                          : PERF_TYPE_SOFTWARE;
+  U64 const* config = (source == Source::HARDWARE) ? hardware
+                                                   : software;
+
+  fds_[0] = _perf_event_open(type, config[0], -1);
+  if (fds_[0] < 0)
+    return false;
+
+  index_[0] = nr_++;
+  for (int i = 1; i < SLOTS; ++i)
+  {
+    // a member the PMU can't count just reads as zero
+    fds_[i] = _perf_event_open(type, config[i], fds_[0]);
+    if (fds_[i] >= 0)
+      index_[i] = nr_++;
+  }
+
+  ioctl(fds_[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+  ioctl(fds_[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+  return true;
+#else
+  return false;
+#endif
+}
+
+
+void ThreadGroup::closePerf()
+{
+  for (int i = 0; i < SLOTS; ++i)
+  {
+    if (fds_[i] >= 0)
+      close(fds_[i]);
+    fds_[i] = index_[i] = -1;
+  }
+  nr_ = 0;
+}
+
+
+void ThreadGroup::read(Sample& sample)
+{
+  memset(&sample, 0, sizeof(sample));
+
+  if (source_ == Source::NONE)
+    return;
+
+  if (source_ == Source::CLOCK)
+  {
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    sample.value[0] = (U64)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+#ifdef __linux__
+    struct rusage usage;
+    if (!getrusage(RUSAGE_THREAD, &usage))
+    {
+      sample.value[1] = usage.ru_nvcsw + usage.ru_nivcsw;
+      sample.value[2] = usage.ru_minflt + usage.ru_majflt;
+    }
+#endif
+    return;
+  }
+
+  U64 buffer[1 + SLOTS];
+  ssize_t want = (1 + nr_) * sizeof(U64);
+  if (::read(fds_[0], buffer, want) != want)
+    return;
+
+  for (int i = 0; i < SLOTS; ++i)
+    if (index_[i] >= 0)
+      sample.value[i] = buffer[1 + index_[i]];
+}
+
+
+Counters& ThreadGroup::lookup(char const* method)
+{
+  Cached& cached = cache_[((uintptr_t)method >> 3) & (CACHED - 1)];
+  if (cached.method != method)
+  {
+    std::lock_guard<std::mutex> guard(lock_);
+    cached.counters = &stats_[method];
+    cached.method = method;
+  }
+  return *cached.counters;
+}
+
+
+void ThreadGroup::record(char const* method, Sample const& delta)
+{
+  if (source_ == Source::NONE)
+    return;
+
+  Counters& counters = lookup(method);
+  counters.calls.fetch_add(1, std::memory_order_relaxed);
+  for (int i = 0; i < SLOTS; ++i)
+    counters.total[i].fetch_add(delta.value[i],
+                                std::memory_order_relaxed);
+}
+
+
+void ThreadGroup::collect(StatsMap& into)
+{
+  std::lock_guard<std::mutex> guard(lock_);
+
+  for (auto const& entry : stats_)
+  {
+    Stats stats;
+    stats.calls = entry.second.calls.load(std::memory_order_relaxed);
+    if (!stats.calls)
+      continue;
+
+    for (int i = 0; i < SLOTS; ++i)
+      stats.total.value[i] =
+        entry.second.total[i].load(std::memory_order_relaxed);
+    _accumulate(into[entry.first], stats);
+  }
+}
+
+
+// zeroes rather than erases, since the owning thread may be holding
+// cached pointers into 'stats_'
+void ThreadGroup::clear()
+{
+  std::lock_guard<std::mutex> guard(lock_);
+
+  for (auto& entry : stats_)
+  {
+    entry.second.calls.store(0, std::memory_order_relaxed);
+    for (int i = 0; i < SLOTS; ++i)
+      entry.second.total[i].store(0, std::memory_order_relaxed);
+  }
+}
+
+
+static StatsMap
+_collect_all()
+{
+  Registry& registry = _registry();
+  std::lock_guard<std::mutex> guard(registry.lock);
+
+  StatsMap all = registry.retired;
+  for (ThreadGroup* group : registry.live)
+    group->collect(all);
+
+  return all;
+}
+
+
+Source
+CX::Perf::get_source()
+{
+  ThreadGroup* group = _get_group();
+  return group ? group->source() : Source::NONE;
+}
+
+
+char const*
+CX::Perf::get_slot_name(Source source, int slot)
+{
+  static char const* const names[][SLOTS] =
+  {
+    { "-",      "-",            "-",           "-"             },
+    { "cycles", "instructions", "llc-misses",  "branch-misses" },
+    { "task-ns","ctx-switches", "page-faults", "migrations"    },
+    { "cpu-ns", "ctx-switches", "page-faults", "-"             },
+  };
+
+  if ((slot < 0) || (slot >= SLOTS))
+    return "-";
+
+  return names[static_cast<U32>(source)][slot];
+}
+
+
+void
+CX::Perf::read_counters(Sample& sample)
+{
+  ThreadGroup* group = _get_group();
+  if (group)
+    group->read(sample);
+  else
+    memset(&sample, 0, sizeof(sample));
+}
+
+
+void
+CX::Perf::record(char const* method, Sample const& start)
+{
+  ThreadGroup* group = _get_group();
+  if (!group)
+    return;
+
+  Sample delta;
+  group->read(delta);
+  for (int i = 0; i < SLOTS; ++i)
+    delta.value[i] -= start.value[i];
+
+  group->record(method, delta);
+}
+
+
+bool
+CX::Perf::get_stats(char const* method, Stats& stats)
+{
+  StatsMap all = _collect_all();
+
+  auto found = all.find(method);
+  if (found == all.end())
+    return false;
+
+  stats = found->second;
+  return true;
+}
+
+
+void
+CX::Perf::reset()
+{
+  Registry& registry = _registry();
+  std::lock_guard<std::mutex> guard(registry.lock);
+
+  registry.retired.clear();
+  for (ThreadGroup* group : registry.live)
+    group->clear();
+}
+
+
+static double
+_ratio(U64 num, U64 den, double scale)
+{
+  return den ? (scale * num) / den : 0.0;
+}
+
+
+void
+CX::Perf::report(FILE* file)
+{
+  if (!file)
+    return;
+
+  StatsMap all = _collect_all();
+
+  Source source;
+  U32 unmeasured;
+  {
+    Registry& registry = _registry();
+    std::lock_guard<std::mutex> guard(registry.lock);
+    source = registry.source;
+    unmeasured = registry.unmeasured;
+  }
+
+  // hottest first, by whatever the leading counter is
+  std::vector<std::pair<char const*, Stats>> rows(all.begin(), all.end());
+  std::sort(rows.begin(), rows.end(),
+            [](auto const& a, auto const& b)
+            {
+              return a.second.total.value[0] > b.second.total.value[0];
+            });
+
+  fprintf(file, "counter source: %s", _source_name(source));
+  if (unmeasured)
+    fprintf(file, "; %" PRIu32 " thread(s) couldn't open it",
+            unmeasured);
+  fprintf(file, "\n");
+
+  if (source == Source::HARDWARE)
+  {
+    fprintf(file, "%10s %14s %14s %6s %9s %9s  %s\n",
+            "calls", "cycles", "instructions",
+            "IPC", "LLC/ki", "br-mis/ki", "method");
+    for (auto const& row : rows)
+    {
+      U64 const* v = row.second.total.value;
+      fprintf(file, "%10" PRIu64 " %14" PRIu64 " %14" PRIu64
+                    " %6.2f %9.3f %9.3f  %s\n",
+              row.second.calls, v[0], v[1],
+              _ratio(v[1], v[0], 1.0),
+              _ratio(v[2], v[1], 1000.0),
+              _ratio(v[3], v[1], 1000.0),
+              row.first);
+    }
+  }
+  else
+  {
+    fprintf(file, "%10s %14s %12s %12s %12s  %s\n",
+            "calls", get_slot_name(source, 0), "ns/call",
+            get_slot_name(source, 1), get_slot_name(source, 2),
+            "method");
+    for (auto const& row : rows)
+    {
+      U64 const* v = row.second.total.value;
+      fprintf(file, "%10" PRIu64 " %14" PRIu64 " %12.1f %12" PRIu64
+                    " %12" PRIu64 "  %s\n",
+              row.second.calls, v[0],
+              _ratio(v[0], row.second.calls, 1.0),
+              v[1], v[2], row.first);
+    }
+  }
+
+  fflush(file);
+}
+
+
+namespace
+{
+  // the main thread's thread_local ThreadGroup is retired before
+  // this runs, so its totals are included.
+  CX::ExitReport g_exitreport("CX_PERFREPORT",
+                              [](FILE* file) { report(file); });
+}
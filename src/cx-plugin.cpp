@@ -0,0 +1,313 @@
+// vim: set tabstop=2 softtabstop=2 shiftwidth=2 expandtab :
+/*
+ * Copyright (c) 2026, Ryan V. Bissell
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ * See the enclosed "LICENSE" file for exact license terms.
+ */
+
+#define CX_TRACE_SECTION "plugin"
+
+#include "cx-plugin.hpp"
+#include "cx-tracedebug.hpp"
+
+#include <dirent.h>
+#include <dlfcn.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <fstream>
+
+using namespace CX;
+
+
+namespace
+{
+  // deferred_ is keyed on both names at once
+  std::string _deferral(std::string const& factory, std::string const& key)
+  {
+    return factory + '\n' + key;
+  }
+
+
+  bool _ends_with(std::string const& text, std::string const& suffix)
+  {
+    return (text.size() > suffix.size()) &&
+           !text.compare(text.size() - suffix.size(), suffix.size(),
+                         suffix);
+  }
+
+
+  // an entry of PluginLoader::unclaimed_; never zero, as they start
+  size_t _unclaimed(size_t hash, size_t generation)
+  {
+    return (hash ^ (generation * 0x9e3779b97f4a7c15ULL)) | 1;
+  }
+
+
+  std::string _trim(std::string const& text)
+  {
+    size_t first = text.find_first_not_of(" \t\r");
+    if (first == std::string::npos)
+      return std::string();
+    size_t last = text.find_last_not_of(" \t\r");
+    return text.substr(first, last - first + 1);
+  }
+}
+
+
+PluginLoader::~PluginLoader()
+{
+  // their hooks would call us; unhooking waits for any that are
+  for (auto const& published : published_)
+    if (published.second.unhook)
+      published.second.unhook(published.second.factory);
+}
+
+
+void
+PluginLoader::publish(std::string const& name, void* factory,
+                      char const* type, void (*unhook)(void* factory))
+{
+  Published replaced = {};
+  {
+    std::lock_guard<std::recursive_mutex> lock(lock_);
+    Published& published = published_[name];
+    replaced = published;
+    published = { factory, type, unhook };
+  }
+
+  // unhooking waits for lookups in the hook, which may want the lock
+  if (replaced.unhook && (replaced.factory != factory))
+    replaced.unhook(replaced.factory);
+}
+
+
+void*
+PluginLoader::find(char const* name, char const* type) const
+{
+  std::lock_guard<std::recursive_mutex> lock(lock_);
+  auto iter = published_.find(name);
+  if (iter == published_.end())
+    return nullptr;
+
+  // type_infos aren't unique across shared objects; their names are
+  if (strcmp(iter->second.type, type))
+    return nullptr;
+  return iter->second.factory;
+}
+
+
+char const*
+PluginLoader::Path() const
+{
+  return registering_;
+}
+
+
+CX_METHOD(PluginResult PluginLoader::open, Plugin& plugin)
+  plugin.handle = dlopen(plugin.path.c_str(), RTLD_LAZY | RTLD_LOCAL);
+  if (!plugin.handle)
+    CX_FAIL(PluginException, PluginError::OPEN, "%s", dlerror());
+
+  // plugins are never unloaded, even those that fail to register;
+  // they may have defined something before failing
+  PluginEntry entry = reinterpret_cast<PluginEntry>(
+                        dlsym(plugin.handle, CX_PLUGIN_ENTRYNAME));
+  if (!entry)
+  {
+    CX_FAIL(PluginException, PluginError::NOENTRY,
+            "'%s' has no " CX_PLUGIN_ENTRYNAME "()", plugin.path.c_str());
+  }
+
+  char const* outer = registering_;
+  registering_ = plugin.path.c_str();
+  bool registered = entry(*this);
+  registering_ = outer;
+
+  if (!registered)
+  {
+    CX_FAIL(PluginException, PluginError::REJECTED,
+            "'%s' failed to register", plugin.path.c_str());
+  }
+  CX_RETURN(PluginResult());
+CX_ENDMETHOD
+
+
+CX_METHOD(PluginResult PluginLoader::load, size_t index)
+  // a plugin's entry point may miss in a factory, and so load
+  // another plugin; so plugins_ may grow beneath 'plugin'.  it may
+  // even miss one of its own keys, which mustn't load it again.
+  plugins_[index].state = State::LOADING;
+  Plugin plugin = plugins_[index];
+  PluginResult result = open(plugin);
+  plugin.state = result.Ok() ? State::LOADED : State::FAILED;
+  if (!result.Ok())
+    failures_.push_back({ plugin.path, result.Error().Reason() });
+  plugins_[index] = plugin;
+  CX_RETURN(result);
+CX_ENDMETHOD
+
+
+CX_METHOD(PluginResult PluginLoader::Load, char const* path)
+  std::lock_guard<std::recursive_mutex> lock(lock_);
+
+  auto iter = std::find_if(plugins_.begin(), plugins_.end(),
+                           [&](Plugin const& plugin)
+                           {
+                             return plugin.path == path;
+                           });
+  if ((iter != plugins_.end()) && ((iter->state == State::LOADED) ||
+                                   (iter->state == State::LOADING)))
+    CX_RETURN(PluginResult());
+
+  size_t index = iter - plugins_.begin();
+  if (iter == plugins_.end())
+    plugins_.push_back({ path, State::DEFERRED, nullptr });
+  CX_RETURN(load(index));
+CX_ENDMETHOD
+
+
+CX_METHOD(PluginResult PluginLoader::readManifest, std::string const& path,
+                                                   size_t index)
+  std::ifstream manifest(path);
+  if (!manifest)
+    CX_FAIL(PluginException, PluginError::MANIFEST, "can't read '%s'",
+            path.c_str());
+
+  std::vector<std::string> deferrals;
+  std::string line;
+  for (unsigned number = 1; std::getline(manifest, line); ++number)
+  {
+    line = _trim(line.substr(0, line.find('#')));
+    if (line.empty())
+      continue;
+
+    size_t space = line.find_first_of(" \t");
+    std::string key = (space == std::string::npos) ?
+                        std::string() : _trim(line.substr(space));
+    if (key.empty())
+    {
+      CX_FAIL(PluginException, PluginError::MANIFEST,
+              "%s:%u: expected 'factory key'", path.c_str(), number);
+    }
+    deferrals.push_back(_deferral(line.substr(0, space), key));
+  }
+
+  // the first plugin to claim a key keeps it; and any key it claims
+  // may have gone unclaimed before
+  for (auto const& deferral : deferrals)
+    deferred_.emplace(deferral, index);
+  generation_.fetch_add(1, std::memory_order_release);
+  CX_RETURN(PluginResult());
+CX_ENDMETHOD
+
+
+CX_METHOD(PluginCount PluginLoader::Scan, char const* directory,
+                                          char const* suffix)
+  std::lock_guard<std::recursive_mutex> lock(lock_);
+
+  DIR* dir = opendir(directory);
+  if (!dir)
+  {
+    CX_FAIL(PluginException, PluginError::DIRECTORY, "'%s': %s",
+            directory, strerror(errno));
+  }
+
+  std::vector<std::string> names;
+  while (dirent* entry = readdir(dir))
+    if (_ends_with(entry->d_name, suffix))
+      names.push_back(entry->d_name);
+  closedir(dir);
+
+  // in a predictable order, since earlier plugins win conflicts
+  std::sort(names.begin(), names.end());
+
+  for (auto const& name : names)
+  {
+    std::string path = std::string(directory) + "/" + name;
+    std::string manifest =
+      path.substr(0, path.size() - strlen(suffix)) + ".cxplugin";
+
+    size_t index = plugins_.size();
+    plugins_.push_back({ path, State::DEFERRED, nullptr });
+
+    if (access(manifest.c_str(), F_OK) != 0)
+    {
+      load(index);    // failures are kept in failures_
+      continue;
+    }
+
+    PluginResult deferred = readManifest(manifest, index);
+    if (!deferred.Ok())
+    {
+      plugins_[index].state = State::FAILED;
+      failures_.push_back({ path, deferred.Error().Reason() });
+    }
+  }
+
+  CX_RETURN(PluginCount(names.size()));
+CX_ENDMETHOD
+
+
+bool
+PluginLoader::unclaimed(size_t hash) const
+{
+  size_t const generation = generation_.load(std::memory_order_acquire);
+  return unclaimed_[hash % UNCLAIMED].load(std::memory_order_relaxed) ==
+         _unclaimed(hash, generation);
+}
+
+
+bool
+PluginLoader::loadFor(std::string const& factory, std::string const& key,
+                      size_t hash)
+{
+  std::lock_guard<std::recursive_mutex> lock(lock_);
+
+  // a plugin gets one chance; one loading now is having it
+  auto iter = deferred_.find(_deferral(factory, key));
+  if ((iter == deferred_.end()) ||
+      (plugins_[iter->second].state != State::DEFERRED))
+  {
+    size_t const generation = generation_.load(std::memory_order_relaxed);
+    unclaimed_[hash % UNCLAIMED].store(_unclaimed(hash, generation),
+                                       std::memory_order_relaxed);
+    return false;
+  }
+
+  return load(iter->second).Ok();
+}
+
+
+size_t
+PluginLoader::Loaded() const
+{
+  std::lock_guard<std::recursive_mutex> lock(lock_);
+  return std::count_if(plugins_.begin(), plugins_.end(),
+                       [](Plugin const& plugin)
+                       {
+                         return plugin.state == State::LOADED;
+                       });
+}
+
+
+size_t
+PluginLoader::Deferred() const
+{
+  std::lock_guard<std::recursive_mutex> lock(lock_);
+  return std::count_if(plugins_.begin(), plugins_.end(),
+                       [](Plugin const& plugin)
+                       {
+                         return plugin.state == State::DEFERRED;
+                       });
+}
+
+
+std::vector<PluginLoader::Failure>
+PluginLoader::Failures() const
+{
+  std::lock_guard<std::recursive_mutex> lock(lock_);
+  return failures_;
+}
@@ -0,0 +1,149 @@
+// vim: set tabstop=2 softtabstop=2 shiftwidth=2 expandtab :
+/*
+ * Copyright (c) 2026, Ryan V. Bissell
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ * See the enclosed "LICENSE" file for exact license terms.
+ */
+
+#include "cx-throwstats.hpp"
+#include "cx-tracedebug.hpp"
+
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+using namespace CX::ThrowStats;
+
+
+namespace
+{
+  // sites are only ever pushed, never removed; so walking the
+  // list needs no lock.
+  std::atomic<Site*> g_sites(nullptr);
+  std::atomic<unsigned> g_nextshard(0);
+
+
+  U64 _now_ns()
+  {
+    auto now = std::chrono::steady_clock::now().time_since_epoch();
+    U64 ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                                        now).count();
+    return ns ? ns : 1;   // zero means 'never thrown'
+  }
+}
+
+
+void
+CX::ThrowStats::enroll(Site& site)
+{
+  U64 expected = 0;
+  if (!site.first.compare_exchange_strong(expected, _now_ns()))
+    return;   // some other thread got here first
+
+  Site* head = g_sites.load(std::memory_order_relaxed);
+  do {
+    site.next = head;
+  } while (!g_sites.compare_exchange_weak(head, &site,
+                                          std::memory_order_release,
+                                          std::memory_order_relaxed));
+}
+
+
+unsigned
+CX::ThrowStats::get_shard()
+{
+  static thread_local unsigned shard =
+    g_nextshard.fetch_add(1, std::memory_order_relaxed) % SHARDS;
+  return shard;
+}
+
+
+Site const*
+CX::ThrowStats::get_sites()
+{
+  return g_sites.load(std::memory_order_acquire);
+}
+
+
+U64
+CX::ThrowStats::get_count(Site const& site)
+{
+  U64 total = 0;
+  for (auto const& shard : site.shards)
+    total += shard.count.load(std::memory_order_relaxed);
+  return total;
+}
+
+
+double
+CX::ThrowStats::get_rate(Site const& site)
+{
+  U64 first = site.first.load(std::memory_order_relaxed);
+  if (!first)
+    return 0.0;
+
+  // a site that has only just started throwing has no rate yet
+  double seconds = (_now_ns() - first) / 1e9;
+  return (seconds > 1e-3) ? get_count(site) / seconds : 0.0;
+}
+
+
+void
+CX::ThrowStats::reset()
+{
+  for (Site const* site = get_sites(); site; site = site->next)
+  {
+    Site& counted = const_cast<Site&>(*site);
+    for (auto& shard : counted.shards)
+      shard.count.store(0, std::memory_order_relaxed);
+    counted.first.store(_now_ns(), std::memory_order_relaxed);
+  }
+}
+
+
+void
+CX::ThrowStats::report(FILE* file)
+{
+  if (!file)
+    return;
+
+  struct Row
+  {
+    Site const* site;
+    U64 count;
+  };
+
+  std::vector<Row> rows;
+  for (Site const* site = get_sites(); site; site = site->next)
+    rows.push_back({ site, get_count(*site) });
+
+  std::stable_sort(rows.begin(), rows.end(),
+                   [](Row const& a, Row const& b)
+                   {
+                     return a.count > b.count;
+                   });
+
+  fprintf(file, "%10s %12s  %-24s %s\n",
+          "throws", "per-second", "where", "what (type) in method");
+  for (auto const& row : rows)
+  {
+    fprintf(file, "%10" PRIu64 " %12.1f  %-24s %s (%s) in %s\n",
+            row.count, get_rate(*row.site), row.site->where,
+            row.site->what, row.site->type, row.site->method);
+  }
+
+  fflush(file);
+}
+
+
+namespace
+{
+  CX::ExitReport g_exitreport("CX_THROWSTATS",
+                              [](FILE* file) { report(file); });
+}
@@ -15,6 +15,8 @@
 #include <errno.h>
 #include <cstdlib>
 #include <cstdarg>
+#include <ctime>    // time(), for get_assert_message()
+#include <exception>
 
 // changing this to a static and wrapping it with get()/set()
 // because g++ 4.8.4 didn't seem to be extern'ing the original form
@@ -34,6 +36,8 @@ static  char const *g_tracefile = nullptr;
 #ifdef CX_OPT_TRACING
 static U64 g_tracelevel = 0;
 static char g_tracetab[256] = "";
+
+std::atomic<U8> CX::detail::trace_state(CX::detail::TRACEUNKNOWN);
 #endif
 
 // this has to be defined even when CX_OPT_TRACING is undefined,
@@ -239,10 +243,18 @@ bool
 CX::is_section_active(const char* section)
 {
   if (!CX::is_enabled())
+  {
+    detail::trace_state.store(detail::TRACEOFF, std::memory_order_relaxed);
     return false;
+  }
 
   if (!g_traceenv)
+  {
     g_traceenv = _init_env_string("CX_TRACE");
+    detail::trace_state.store(*g_traceenv ? detail::TRACEON
+                                          : detail::TRACEOFF,
+                              std::memory_order_relaxed);
+  }
 
   if (!g_traceenv || !*g_traceenv)
     return false;  // empty is treated the same as undefined
@@ -264,6 +276,35 @@ CX::is_section_active(const char* section)
 }
 
 
+bool
+CX::TraceScope::enter()
+{
+  if (!CX::is_section_active(site_->section))
+    return false;
+
+  uncaught_ = std::uncaught_exceptions();
+  CX::traceout(site_->section, "%s", site_->entry);
+  CX::shift_in();
+  return true;
+}
+
+
+void
+CX::TraceScope::leave()
+{
+  // when unwinding, leave the trace level where it is;
+  // CX_CATCH resets it to that of the catching method.
+  if (std::uncaught_exceptions() > uncaught_)
+    return;
+
+  CX::shift_out();
+  CX::traceout(site_->section, "<\n");
+
+  if (returning_)
+    CX::flush();
+}
+
+
 void
 CX::traceout(char const* section, char const* format, ...)
 {
@@ -471,3 +512,54 @@ CX::get_assert_message()
   return g_assert_messages[msg];
 }
 
+
+CX::ExitReport::~ExitReport()
+{
+  char const* path = getenv(envvar_);
+  if (!path || !*path)
+    return;
+
+  if (!strcmp(path, "-"))
+  {
+    report_(stderr);
+    return;
+  }
+
+  FILE* file = fopen(path, "w");
+  if (!file)
+  {
+    fprintf(stderr, "Unable to open %s '%s'\n", envvar_, path);
+    return;
+  }
+  report_(file);
+  fclose(file);
+}
+
+
+void
+CX::assert_failed(AssertSite const* site, char const* format, ...)
+{
+  CX_ERROROUT("\n!!! %s\n\n", CX::get_assert_message());
+  CX_ERROROUT("    What:  assertion / debugger-trap\n");
+  CX_ERROROUT("    Why:   ");
+
+  if (format)
+  {
+    va_list args;
+    va_start(args, format);
+    if (!CX::is_enabled())
+      ::vfprintf(stderr, format, args);
+    else
+      _trace_vfprintf(false, g_errorfile, format, args);
+    va_end(args);
+  }
+
+  CX_ERROROUT("\n");
+  CX_ERROROUT("    How:   '%s'\n", site->expr);
+  CX_ERROROUT("    Who:   '%s'\n", site->function);
+  CX_ERROROUT("    Where: '%s', line %d\n", site->file, site->line);
+  CX::flush();
+  CX_BREAKPOINT;
+  abort();
+}
+
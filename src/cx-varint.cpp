@@ -0,0 +1,335 @@
+// vim: set tabstop=2 softtabstop=2 shiftwidth=2 expandtab :
+/*
+ * Copyright (c) 2026, Ryan V. Bissell
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ * See the enclosed "LICENSE" file for exact license terms.
+ */
+
+#define CX_TRACE_SECTION "varint"
+
+#include "cx-varint.hpp"
+
+#ifdef CX_ENDIAN_X86
+  #include <immintrin.h>
+#endif
+
+using namespace CX::Varint;
+using CX::Endian::Kernel;
+
+
+namespace
+{
+  // one function per element width, for the kernel in use
+  struct Kernels
+  {
+    Kernel kernel;
+    Decoded (*decode16)(U16* out, size_t count, U8 const* in, size_t size);
+    Decoded (*decode32)(U32* out, size_t count, U8 const* in, size_t size);
+    Decoded (*decode64)(U64* out, size_t count, U8 const* in, size_t size);
+  };
+
+
+  // one value at a time, picking up where 'decoded' left off
+  template <typename U>
+  Decoded _decode_scalar(U* out, size_t count, U8 const* in, size_t size,
+                         Decoded decoded)
+  {
+    for (; decoded.count < count; ++decoded.count)
+    {
+      size_t used = decode(out[decoded.count], in + decoded.bytes,
+                           size - decoded.bytes);
+      if (!used)
+        break;
+      decoded.bytes += used;
+    }
+    return decoded;
+  }
+
+  template <typename U>
+  Decoded _decode_scalar(U* out, size_t count, U8 const* in, size_t size)
+  {
+    return _decode_scalar(out, count, in, size, Decoded{ 0, 0 });
+  }
+
+
+#ifdef CX_ENDIAN_X86
+  // Masked VByte (Plaisance, Kurz & Lemire), more or less: the high
+  // bits of 16 bytes are gathered into a mask, and the low 12 bits of
+  // that look up how to shuffle the varints that end within them into
+  // vector lanes; 16-bit lanes when the first few are of one or two
+  // bytes, else 32-bit lanes for those of up to four.  each lane's
+  // 7-bit groups are then squeezed together with shifts and masks.
+  enum { WINDOW = 12 };
+
+  struct Pattern
+  {
+    U8 shuffle[16];
+    U8 count;       // varints decoded; 0 when the first is too long
+    U8 bytes;       // that they take
+    U8 lane;        // 2 or 4 bytes
+    U8 longest;     // of those varints
+  };
+
+
+  Pattern _pattern(unsigned mask)
+  {
+    // the varints that end within the window
+    U8 starts[WINDOW], lengths[WINDOW];
+    size_t varints = 0;
+    for (unsigned start = 0, end = 0; end < WINDOW; ++end)
+    {
+      if (!(mask & (1U << end)))
+      {
+        starts[varints] = start;
+        lengths[varints++] = end - start + 1;
+        start = end + 1;
+      }
+    }
+
+    // how many lead off that fit in each lane width
+    size_t twos = 0, fours = 0;
+    while ((twos < varints) && (twos < 8) && (lengths[twos] <= 2))
+      ++twos;
+    while ((fours < varints) && (fours < 4) && (lengths[fours] <= 4))
+      ++fours;
+
+    Pattern pattern = {};
+    for (auto& index : pattern.shuffle)
+      index = 0x80;   // zeroes
+
+    pattern.lane = ((twos > 4) || (twos == fours)) ? 2 : 4;
+    pattern.count = (pattern.lane == 2) ? twos : fours;
+    for (size_t i = 0; i < pattern.count; ++i)
+    {
+      for (size_t b = 0; b < lengths[i]; ++b)
+        pattern.shuffle[(i * pattern.lane) + b] = starts[i] + b;
+      pattern.bytes += lengths[i];
+      if (lengths[i] > pattern.longest)
+        pattern.longest = lengths[i];
+    }
+    return pattern;
+  }
+
+
+  // built on first use; too big to be worth building as it compiles
+  Pattern const* _patterns()
+  {
+    static Pattern const* const patterns = []()
+      {
+        static Pattern table[1 << WINDOW];
+        for (unsigned mask = 0; mask < (1U << WINDOW); ++mask)
+          table[mask] = _pattern(mask);
+        return table;
+      }();
+    return patterns;
+  }
+
+
+  // stores the 4 U32s of 'v' as 4 U's (which they must fit)
+  template <typename U>
+  CX_TARGET("ssse3")
+  void _store32(U* out, __m128i v)
+  {
+    __m128i const zero = _mm_setzero_si128();
+    if constexpr (sizeof(U) == 2)
+    {
+      __m128i const halves = _mm_setr_epi8(0, 1, 4, 5, 8, 9, 12, 13,
+                                           -1, -1, -1, -1, -1, -1, -1, -1);
+      _mm_storel_epi64(reinterpret_cast<__m128i*>(out),
+                       _mm_shuffle_epi8(v, halves));
+    }
+    else if constexpr (sizeof(U) == 4)
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(out), v);
+    else
+    {
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(out),
+                       _mm_unpacklo_epi32(v, zero));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 2),
+                       _mm_unpackhi_epi32(v, zero));
+    }
+  }
+
+
+  // and the 8 U16s of 'v' as 8 U's
+  template <typename U>
+  CX_TARGET("ssse3")
+  void _store16(U* out, __m128i v)
+  {
+    __m128i const zero = _mm_setzero_si128();
+    if constexpr (sizeof(U) == 2)
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(out), v);
+    else
+    {
+      _store32(out, _mm_unpacklo_epi16(v, zero));
+      _store32(out + 4, _mm_unpackhi_epi16(v, zero));
+    }
+  }
+
+
+  // and the 16 bytes of 'v' as 16 U's
+  template <typename U>
+  CX_TARGET("ssse3")
+  void _store8(U* out, __m128i v)
+  {
+    __m128i const zero = _mm_setzero_si128();
+    if constexpr (sizeof(U) == 2)
+    {
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(out),
+                       _mm_unpacklo_epi8(v, zero));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 8),
+                       _mm_unpackhi_epi8(v, zero));
+    }
+    else
+    {
+      _store16(out, _mm_unpacklo_epi8(v, zero));
+      _store16(out + 8, _mm_unpackhi_epi8(v, zero));
+    }
+  }
+
+
+  // 0hhhhhhh 0lllllll -> 00hhhhhh hlllllll, in each 16-bit lane
+  CX_TARGET("ssse3")
+  __m128i _squeeze16(__m128i x)
+  {
+    __m128i const low7 = _mm_set1_epi16(0x7f);
+    return _mm_or_si128(_mm_and_si128(x, low7),
+                        _mm_srli_epi16(_mm_andnot_si128(low7, x), 1));
+  }
+
+
+  template <typename U>
+  CX_TARGET("ssse3")
+  Decoded _decode_ssse3(U* out, size_t count, U8 const* in, size_t size)
+  {
+    Pattern const* const patterns = _patterns();
+    __m128i const low7 = _mm_set1_epi8(0x7f);
+    __m128i const low14 = _mm_set1_epi32(0x3fff);
+    Decoded decoded = { 0, 0 };
+
+    // every store is of 16 values or fewer; and every load, 16 bytes
+    while (((count - decoded.count) >= 16) &&
+           ((size - decoded.bytes) >= 16))
+    {
+      U* const at = out + decoded.count;
+      __m128i const v =
+        _mm_loadu_si128(reinterpret_cast<__m128i const*>(in +
+                                                         decoded.bytes));
+      unsigned const mask = _mm_movemask_epi8(v);
+
+      // all of one byte, which is common enough to single out
+      if (!mask)
+      {
+        _store8(at, v);
+        decoded.count += 16;
+        decoded.bytes += 16;
+        continue;
+      }
+
+      Pattern const& pattern = patterns[mask & ((1U << WINDOW) - 1)];
+      if (CX_UNLIKELY(!pattern.count ||
+                      (pattern.longest > MAXBYTES<U>)))
+      {
+        // too long for the lanes, or for a U (or malformed, which
+        // decode() will say)
+        size_t used = decode(*at, in + decoded.bytes,
+                             size - decoded.bytes);
+        if (!used)
+          return decoded;
+        decoded.count += 1;
+        decoded.bytes += used;
+        continue;
+      }
+
+      __m128i const shuffle =
+        _mm_loadu_si128(reinterpret_cast<__m128i const*>(pattern.shuffle));
+      __m128i x = _mm_and_si128(_mm_shuffle_epi8(v, shuffle), low7);
+      if (pattern.lane == 2)
+      {
+        _store16(at, _squeeze16(x));
+      }
+      else
+      {
+        // by pairs of bytes, then by pairs of those
+        x = _squeeze16(x);
+        x = _mm_or_si128(_mm_and_si128(x, low14),
+                         _mm_srli_epi32(_mm_andnot_si128(low14, x), 2));
+
+        // of three bytes, only two bits of the last fit in a U16
+        if constexpr (sizeof(U) == 2)
+        {
+          __m128i const over = _mm_cmpgt_epi32(x, _mm_set1_epi32(0xffff));
+          unsigned const lanes = (1U << (4 * pattern.count)) - 1;
+          if (CX_UNLIKELY(_mm_movemask_epi8(over) & lanes))
+          {
+            // as many as precede it
+            return _decode_scalar(out, count, in, size, decoded);
+          }
+        }
+        _store32(at, x);
+      }
+
+      decoded.count += pattern.count;
+      decoded.bytes += pattern.bytes;
+    }
+
+    return _decode_scalar(out, count, in, size, decoded);
+  }
+#endif
+
+
+  #define CX_KERNELS(kernel, fn)                                      \
+    { Kernel::kernel, &fn<U16>, &fn<U32>, &fn<U64> }
+
+  Kernels const g_kernels[] =
+  {
+    CX_KERNELS(SCALAR, _decode_scalar),
+#ifdef CX_ENDIAN_X86
+    CX_KERNELS(SSSE3, _decode_ssse3),
+#endif
+  };
+
+  #undef CX_KERNELS
+
+
+  CX::Endian::KernelTable g_table(g_kernels);
+}
+
+
+Kernel
+CX::Varint::get_kernel()
+{
+  return g_table.Active().kernel;
+}
+
+
+bool
+CX::Varint::set_kernel(Kernel kernel)
+{
+  return g_table.Select(kernel);
+}
+
+
+Decoded
+CX::Varint::detail::decode16(U16* out, size_t count, U8 const* in,
+                             size_t size)
+{
+  return g_table.Active().decode16(out, count, in, size);
+}
+
+
+Decoded
+CX::Varint::detail::decode32(U32* out, size_t count, U8 const* in,
+                             size_t size)
+{
+  return g_table.Active().decode32(out, count, in, size);
+}
+
+
+Decoded
+CX::Varint::detail::decode64(U64* out, size_t count, U8 const* in,
+                             size_t size)
+{
+  return g_table.Active().decode64(out, count, in, size);
+}
@@ -0,0 +1,77 @@
+// vim: set tabstop=2 softtabstop=2 shiftwidth=2 expandtab :
+/*
+ * Copyright (c) 2026, Ryan V. Bissell
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ * See the enclosed "LICENSE" file for exact license terms.
+ */
+
+#define CX_TRACE_SECTION "asserts"
+
+#include "cx-test-support.hpp"
+#include "cx-tracedebug.hpp"
+
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <string>
+
+
+// what the assertion in 'fn' prints, as it dies
+template <typename TFn>
+static std::string
+_dies(TFn fn)
+{
+  int fds[2];
+  CX_TEST_ASSERT(pipe(fds) == 0);
+
+  fflush(nullptr);
+  pid_t child = fork();
+  CX_TEST_ASSERT(child >= 0);
+  if (child == 0)
+  {
+    dup2(fds[1], STDERR_FILENO);
+    close(fds[0]);
+    fn();
+    _exit(EXIT_SUCCESS);   // it didn't
+  }
+
+  close(fds[1]);
+  std::string output;
+  char buffer[256];
+  ssize_t got;
+  while ((got = read(fds[0], buffer, sizeof(buffer))) > 0)
+    output.append(buffer, got);
+  close(fds[0]);
+
+  int status;
+  CX_TEST_ASSERT(waitpid(child, &status, 0) == child);
+  CX_TEST_ASSERT(WIFSIGNALED(status));
+  return output;
+}
+
+
+void Test_ASSERT(int two)
+{
+  printf("Testing CX_ASSERT with and without a message...\n");
+
+  CX_ASSERT(two == 2);
+  CX_ASSERT(two == 2, "two was %d\n", two);
+  CX_ASSERT(two == 2, "no arguments\n");
+
+  std::string bare = _dies([=]() { CX_ASSERT(two == 3); });
+  CX_TEST_ASSERT(bare.find("How:   'two == 3'") != std::string::npos);
+
+  std::string said = _dies([=]() { CX_ASSERT(two == 3, "two=%d", two); });
+  CX_TEST_ASSERT(said.find("Why:   two=2") != std::string::npos);
+}
+
+
+int main(int argc, char** argv)
+{
+  Test_ASSERT(argc + 1);
+
+  exit(EXIT_SUCCESS);
+}
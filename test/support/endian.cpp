@@ -11,7 +11,10 @@
 #include "cx-test-support.hpp"
 #include "cx-endian.hpp"
 
+#include <string.h>
+#include <array>
 #include <iostream>
+#include <vector>
 
 void Test_HOST()
 {
@@ -85,6 +88,179 @@ void Test_64BIT()
 }
 
 
+void Test_CONSTEXPR()
+{
+  static_assert(CX::Endian::HOST == CX::Endian::Order::LITTLE, "");
+  static_assert(CX::Endian::betoh((U16)0x0102) == 0x0201, "");
+  static_assert(CX::Endian::htobe((U32)0x01020304) == 0x04030201, "");
+  static_assert(CX::Endian::letoh((S64)-2) == -2, "");
+  static_assert(CX::Endian::htobe((S16)-2) == (S16)0xfeff, "");
+  static_assert(CX::Endian::betoh((U8)0x12) == 0x12, "");
+
+  constexpr CX::Endian::be<U32> big(0x01020304);
+  static_assert(big.Bytes()[0] == 0x01, "");
+  static_assert(big == 0x01020304, "");
+  constexpr CX::Endian::le<U32> little(0x01020304);
+  static_assert(little.Bytes()[0] == 0x04, "");
+  static_assert(little.Get() == 0x01020304, "");
+}
+
+
+// as it might be laid out on disk
+struct TestHeader
+{
+  CX::Endian::be<U32> magic;
+  CX::Endian::le<U16> version;
+  CX::Endian::be<U64> size;
+  CX::Endian::be<S16> offset;
+};
+
+void Test_WRAPPERS()
+{
+  static_assert(sizeof(TestHeader) == 16, "");
+  static_assert(alignof(TestHeader) == 1, "");
+  static_assert(std::is_trivial<TestHeader>::value, "");
+
+  U8 const bytes[] = { 'C', 'X', 'H', 'D',
+                       0x02, 0x01,
+                       0, 0, 0, 0, 0, 0, 0x10, 0x20,
+                       0xff, 0xfe };
+
+  // read in, as from a file
+  TestHeader header;
+  memcpy(&header, bytes, sizeof(header));
+  CX_TEST_ENDIANNESS((U32)header.magic, 0x43584844);
+  CX_TEST_ENDIANNESS((U16)header.version, 0x0102);
+  CX_TEST_ENDIANNESS((U64)header.size, 0x1020);
+  CX_TEST_ENDIANNESS((S16)header.offset, -2);
+
+  // and written back out
+  header.version = 0x0304;
+  header.size = header.size + 1;
+  header.offset = 3;
+  U8 out[sizeof(header)];
+  memcpy(out, &header, sizeof(out));
+  CX_TEST_ENDIANNESS(out[4] + 0, 0x04);
+  CX_TEST_ENDIANNESS(out[5] + 0, 0x03);
+  CX_TEST_ENDIANNESS(out[13] + 0, 0x21);
+  CX_TEST_ENDIANNESS(out[15] + 0, 0x03);
+  CX_TEST_ENDIANNESS(memcmp(out, bytes, 4), 0);
+
+  // anywhere, however misaligned
+  U8 buffer[16] = {};
+  auto word = reinterpret_cast<CX::Endian::be<U64>*>(buffer + 3);
+  *word = 0x0102030405060708;
+  CX_TEST_ENDIANNESS(buffer[3] + 0, 0x01);
+  CX_TEST_ENDIANNESS(buffer[10] + 0, 0x08);
+  CX_TEST_ENDIANNESS(word->Get(), 0x0102030405060708);
+}
+
+
+// against the scalar conversions, for every count up to a few vectors
+// (and some beyond), and every misalignment
+template <typename T>
+void _test_bulk()
+{
+  enum { GUARD = 0xa5 };
+  std::vector<U8> in(4096), out(4096), expect(4096);
+  for (size_t i = 0; i < in.size(); ++i)
+    in[i] = static_cast<U8>((i * 7) + 1);
+
+  for (size_t count = 0; count < 400; count += (count < 80) ? 1 : 37)
+  {
+    for (size_t offset = 0; offset < 8; ++offset)
+    {
+      size_t const bytes = count * sizeof(T);
+      U8* to = out.data() + offset;
+      U8 const* from = in.data() + (7 - offset);
+
+      for (size_t i = 0; i < count; ++i)
+      {
+        T value;
+        memcpy(&value, from + (i * sizeof(T)), sizeof(T));
+        value = CX::Endian::betoh(value);
+        memcpy(expect.data() + (i * sizeof(T)), &value, sizeof(T));
+      }
+
+      memset(out.data(), GUARD, out.size());
+      CX::Endian::betoh(reinterpret_cast<T*>(to),
+                        reinterpret_cast<T const*>(from), count);
+      CX_TEST_ASSERT(!memcmp(to, expect.data(), bytes));
+      CX_TEST_ASSERT((offset == 0) || (out[offset - 1] == GUARD));
+      CX_TEST_ASSERT(to[bytes] == GUARD);
+
+      // in place
+      memcpy(to, from, bytes);
+      CX::Endian::htobe(reinterpret_cast<T*>(to), count);
+      CX_TEST_ASSERT(!memcmp(to, expect.data(), bytes));
+      CX_TEST_ASSERT(to[bytes] == GUARD);
+
+      // and back, the other way
+      CX::Endian::letoh(reinterpret_cast<T*>(to), count);
+      CX_TEST_ASSERT(!memcmp(to, expect.data(), bytes));
+    }
+  }
+}
+
+
+void Test_BULK()
+{
+  CX::Endian::Kernel const best = CX::Endian::get_kernel();
+
+  for (auto kernel : { CX::Endian::Kernel::SCALAR,
+                       CX::Endian::Kernel::SSSE3,
+                       CX::Endian::Kernel::AVX2,
+                       CX::Endian::Kernel::AVX512 })
+  {
+    char const* name = CX::Endian::kernel_name(kernel);
+    if (!CX::Endian::set_kernel(kernel))
+    {
+      printf("Skipping the %s kernel; this CPU lacks it.\n", name);
+      CX_TEST_ASSERT(kernel != CX::Endian::Kernel::SCALAR);
+      continue;
+    }
+
+    printf("Testing the %s kernel...\n", name);
+    CX_TEST_ASSERT(CX::Endian::get_kernel() == kernel);
+    _test_bulk<U16>();
+    _test_bulk<S32>();
+    _test_bulk<U64>();
+  }
+
+  CX_TEST_ASSERT(CX::Endian::set_kernel(best));
+}
+
+
+void Test_ARRAYS()
+{
+  std::vector<U32> words = { 0x01020304, 0x05060708, 0x090a0b0c };
+  CX::Endian::betoh(words);
+  CX_TEST_ENDIANNESS(words[2], 0x0c0b0a09);
+
+  std::array<S16, 2> shorts = { 0x0102, -2 };
+  CX::Endian::htobe(shorts);
+  CX_TEST_ENDIANNESS(shorts[0], 0x0201);
+  CX_TEST_ENDIANNESS(shorts[1], (S16)0xfeff);
+
+  U64 longs[] = { 0x0102030405060708 };
+  CX::Endian::htole(longs);
+  CX_TEST_ENDIANNESS(longs[0], 0x0102030405060708);
+  CX::Endian::betoh(longs);
+  CX_TEST_ENDIANNESS(longs[0], 0x0807060504030201);
+
+  U8 bytes[] = { 1, 2 };
+  CX::Endian::betoh(bytes);
+  CX_TEST_ENDIANNESS(bytes[0] + 0, 1);
+
+  // out of place, leaving the input be
+  U16 const in[] = { 0x0102, 0x0304 };
+  U16 out[2];
+  CX::Endian::betoh(out, in, 2);
+  CX_TEST_ENDIANNESS(out[1], 0x0403);
+  CX_TEST_ENDIANNESS(in[1], 0x0304);
+}
+
+
 int main(int argc, char** argv)
 {
   Test_HOST();
@@ -92,6 +268,10 @@ int main(int argc, char** argv)
   Test_16BIT();
   Test_32BIT();
   Test_64BIT();
+  Test_CONSTEXPR();
+  Test_WRAPPERS();
+  Test_BULK();
+  Test_ARRAYS();
 
   exit(EXIT_SUCCESS);
 }
@@ -0,0 +1,201 @@
+// vim: set tabstop=2 softtabstop=2 shiftwidth=2 expandtab :
+/*
+ * Copyright (c) 2026, Ryan V. Bissell
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ * See the enclosed "LICENSE" file for exact license terms.
+ */
+
+// Byte-swapping throughput of each bulk kernel the CPU has, for each
+// element width, over buffers that fit in L1, in L2 and in neither;
+// out of place, and then in place.  'LOOP' is the same done one
+// betoh() at a time, for comparison.  Reported as GB/s (of input.)
+//
+// Then decoding 16-byte records with a ByteReader, each one read
+// whole as a struct of be<> fields ('RECORDS'), or by field from a
+// Take()n window ('WINDOWS'); and by hand, with memcpy() and betoh()
+// ('MEMCPY'), for comparison.  Also reported as GB/s.
+//
+// Environment:
+//   CX_BENCHMS         minimum milliseconds per measurement (20)
+
+#include "cx-test-support.hpp"
+#include "cx-endian.hpp"
+#include "cx-endianio.hpp"
+
+#include <chrono>
+#include <vector>
+
+
+static double g_minimum_ns;
+
+
+// runs 'body' until that takes long enough to trust, and returns
+// GB/s for 'bytes' per call
+template<typename TBody>
+static double
+_time(size_t bytes, TBody body)
+{
+  U64 iterations = 1;
+  for (;;)
+  {
+    auto start = std::chrono::steady_clock::now();
+    for (U64 i = 0; i < iterations; ++i)
+    {
+      body();
+      asm volatile("" ::: "memory");
+    }
+    auto stop = std::chrono::steady_clock::now();
+
+    std::chrono::duration<double, std::nano> elapsed = stop - start;
+    if ((elapsed.count() >= g_minimum_ns) || (iterations >= (1U << 24)))
+      return (iterations * bytes) / elapsed.count();
+    iterations *= 2;
+  }
+}
+
+
+template<typename T>
+static void
+_bench(char const* name, size_t bytes, bool loop)
+{
+  size_t count = bytes / sizeof(T);
+  std::vector<T> in(count, 0x5a), out(count);
+
+  double gbs[2];
+  if (loop)
+  {
+    gbs[0] = _time(bytes, [&]()
+                   {
+                     for (size_t i = 0; i < count; ++i)
+                       out[i] = CX::Endian::betoh(in[i]);
+                   });
+    gbs[1] = _time(bytes, [&]()
+                   {
+                     for (auto& value : out)
+                       value = CX::Endian::betoh(value);
+                   });
+  }
+  else
+  {
+    gbs[0] = _time(bytes, [&]()
+                   {
+                     CX::Endian::betoh(out.data(), in.data(), count);
+                   });
+    gbs[1] = _time(bytes, [&]()
+                   {
+                     CX::Endian::betoh(out);
+                   });
+  }
+
+  fprintf(stderr, "endian,%s,%zu,%zu,%.2f,%.2f\n",
+          name, sizeof(T) * 8, bytes, gbs[0], gbs[1]);
+}
+
+
+template<typename T>
+static void
+_bench_widths(char const* name, bool loop = false)
+{
+  for (size_t bytes : { 16 << 10, 512 << 10, 64 << 20 })
+    _bench<T>(name, bytes, loop);
+}
+
+
+struct BenchRecord
+{
+  CX::Endian::be<U32> id;
+  CX::Endian::be<U32> flags;
+  CX::Endian::be<U64> value;
+};
+
+
+static void
+_bench_reader(size_t bytes)
+{
+  enum { RECORD = sizeof(BenchRecord) };
+  static_assert(RECORD == 16, "");
+
+  std::vector<U8> buffer(bytes);
+  for (size_t i = 0; i < bytes; ++i)
+    buffer[i] = static_cast<U8>(i * 13);
+  size_t const records = bytes / RECORD;
+
+  U64 total = 0;
+  double gbs[3];
+  gbs[0] = _time(bytes, [&]()
+                 {
+                   CX::ByteReader reader(buffer.data(), buffer.size());
+                   for (size_t i = 0; i < records; ++i)
+                   {
+                     BenchRecord record = reader.Read<BenchRecord>();
+                     total += record.id + record.flags + record.value;
+                   }
+                 });
+  gbs[1] = _time(bytes, [&]()
+                 {
+                   CX::ByteReader reader(buffer.data(), buffer.size());
+                   for (size_t i = 0; i < records; ++i)
+                   {
+                     auto record = reader.Take<RECORD>();
+                     total += record.BE<U32, 0>() + record.BE<U32, 4>() +
+                              record.BE<U64, 8>();
+                   }
+                 });
+  gbs[2] = _time(bytes, [&]()
+                 {
+                   U8 const* at = buffer.data();
+                   for (size_t i = 0; i < records; ++i, at += RECORD)
+                   {
+                     U32 id, flags;
+                     U64 value;
+                     memcpy(&id, at, 4);
+                     memcpy(&flags, at + 4, 4);
+                     memcpy(&value, at + 8, 8);
+                     total += CX::Endian::betoh(id) +
+                              CX::Endian::betoh(flags) +
+                              CX::Endian::betoh(value);
+                   }
+                 });
+
+  char const* names[] = { "RECORDS", "WINDOWS", "MEMCPY" };
+  for (int i = 0; i < 3; ++i)
+    fprintf(stderr, "endian,%s,%d,%zu,%.2f\n", names[i], RECORD * 8,
+            bytes, gbs[i]);
+  CX_TEST_ASSERT(total != 0);
+}
+
+
+int main(int argc, char** argv)
+{
+  char const* ms = getenv("CX_BENCHMS");
+  g_minimum_ns = 1e6 * atof((ms && *ms) ? ms : "20");
+
+  CX::Endian::Kernel const best = CX::Endian::get_kernel();
+
+  _bench_widths<U16>("LOOP", true);
+  _bench_widths<U32>("LOOP", true);
+  _bench_widths<U64>("LOOP", true);
+
+  for (auto kernel : { CX::Endian::Kernel::SCALAR,
+                       CX::Endian::Kernel::SSSE3,
+                       CX::Endian::Kernel::AVX2,
+                       CX::Endian::Kernel::AVX512 })
+  {
+    if (!CX::Endian::set_kernel(kernel))
+      continue;
+
+    char const* name = CX::Endian::kernel_name(kernel);
+    _bench_widths<U16>(name);
+    _bench_widths<U32>(name);
+    _bench_widths<U64>(name);
+  }
+
+  CX_TEST_ASSERT(CX::Endian::set_kernel(best));
+
+  for (size_t bytes : { 16 << 10, 512 << 10, 64 << 20 })
+    _bench_reader(bytes);
+
+  exit(EXIT_SUCCESS);
+}
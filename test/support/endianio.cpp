@@ -0,0 +1,205 @@
+// vim: set tabstop=2 softtabstop=2 shiftwidth=2 expandtab :
+/*
+ * Copyright (c) 2026, Ryan V. Bissell
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ * See the enclosed "LICENSE" file for exact license terms.
+ */
+
+#include "cx-test-support.hpp"
+#include "cx-endianio.hpp"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <string>
+
+
+// as it might be laid out on disk
+struct TestHeader
+{
+  CX::Endian::be<U32> magic;
+  CX::Endian::le<U16> version;
+  CX::Endian::be<U64> size;
+};
+
+
+CX_FUNCTION(void Test_STREAM)
+  printf("Testing reading what was written...\n");
+
+  U8 buffer[64];
+  memset(buffer, 0, sizeof(buffer));
+
+  CX::ByteWriter writer(buffer, sizeof(buffer));
+  writer.WriteBE<U32>(0x43584844);
+  writer.WriteLE<U16>(0x0102);
+  writer.Write<U8>(5);
+  writer.WriteString("hello");
+  TestHeader header = { 0x01020304, 7, 0x1122334455667788 };
+  writer.Write(header);
+  writer.WriteBE<S16>(-2);
+  CX_TEST_ASSERT(writer.Offset() == 4 + 2 + 1 + 5 + 14 + 2);
+  CX_TEST_ASSERT(writer.Written().size() == writer.Offset());
+
+  CX_TEST_ASSERT(buffer[0] == 'C');
+  CX_TEST_ASSERT(buffer[4] == 0x02);
+  CX_TEST_ASSERT(buffer[12] == 0x01);   // magic, big-endian
+
+  CX::ByteReader reader(writer.Written());
+  CX_TEST_ASSERT(reader.ReadBE<U32>() == 0x43584844);
+  CX_TEST_ASSERT(reader.ReadLE<U16>() == 0x0102);
+
+  // strings are views of the buffer itself
+  U8 length = reader.Read<U8>();
+  std::string_view text = reader.ReadString(length);
+  CX_TEST_ASSERT(text == "hello");
+  CX_TEST_ASSERT(text.data() == reinterpret_cast<char*>(buffer + 7));
+
+  TestHeader read = reader.Read<TestHeader>();
+  CX_TEST_ASSERT(read.magic == 0x01020304);
+  CX_TEST_ASSERT(read.version == 7);
+  CX_TEST_ASSERT(read.size == 0x1122334455667788);
+
+  CX_TEST_ASSERT(reader.ReadBE<S16>() == -2);
+  CX_TEST_ASSERT(reader.AtEnd());
+  CX_TEST_ASSERT(reader.Remaining() == 0);
+
+  reader.Seek(12);
+  CX_TEST_ASSERT(reader.ReadBE<U32>() == 0x01020304);
+  reader.Skip(10);
+  CX_TEST_ASSERT(reader.Remaining() == 2);
+CX_ENDFUNCTION
+
+
+CX_FUNCTION(void Test_WINDOWS)
+  printf("Testing records checked once...\n");
+
+  U8 buffer[32];
+  memset(buffer, 0xee, sizeof(buffer));
+
+  CX::ByteWriter writer(buffer, sizeof(buffer));
+  writer.Write<U8>(0xaa);
+  auto out = writer.Take<12>();
+  out.PutBE<U32, 0>(0x01020304);
+  out.PutLE<U16, 4>(0x0506);
+  out.PutBE<U32, 8>(0x0708090a);
+  out.Put<U8, 6>(0x11);
+  CX_TEST_ASSERT(writer.Offset() == 13);
+  CX_TEST_ASSERT(buffer[1] == 0x01);
+  CX_TEST_ASSERT(buffer[5] == 0x06);
+  CX_TEST_ASSERT(buffer[8] == 0xee);    // not written
+  CX_TEST_ASSERT(buffer[12] == 0x0a);
+
+  CX::ByteReader reader(buffer, sizeof(buffer));
+  reader.Skip(1);
+  auto in = reader.Take<12>();
+  CX_TEST_ASSERT(reader.Offset() == 13);
+  CX_TEST_ASSERT((in.BE<U32, 0>()) == 0x01020304);
+  CX_TEST_ASSERT((in.LE<U16, 4>()) == 0x0506);
+  CX_TEST_ASSERT((in.Get<U8, 6>()) == 0x11);
+  CX_TEST_ASSERT((in.BE<U32, 8>()) == 0x0708090a);
+  CX_TEST_ASSERT((in.Bytes<4, 2>().data()) == buffer + 5);
+
+  // a length-prefixed record
+  CX::ByteReader whole(buffer, sizeof(buffer));
+  CX::ByteReader part = whole.Split(5);
+  CX_TEST_ASSERT(whole.Offset() == 5);
+  CX_TEST_ASSERT(part.Remaining() == 5);
+  part.Skip(1);
+  CX_TEST_ASSERT(part.ReadBE<U32>() == 0x01020304);
+  CX_TEST_ASSERT(part.AtEnd());
+CX_ENDFUNCTION
+
+
+// true when 'attempt' throws BytesError::BOUNDS
+template <typename TAttempt>
+CX_FUNCTION(bool _overruns, TAttempt attempt)
+  CX_TRY
+    attempt();
+  CX_CATCH(CX::BytesException& e)
+    CX_TEST_ASSERT(e.What() == CX::BytesError::BOUNDS);
+    CX_RETURN(true);
+  CX_ENDTRY
+  CX_RETURN(false);
+CX_ENDFUNCTION
+
+
+CX_FUNCTION(void Test_BOUNDS)
+  printf("Testing reads and writes beyond the end...\n");
+
+  U8 buffer[8] = {};
+  CX::ByteReader reader(buffer, sizeof(buffer));
+  reader.Skip(6);
+
+  CX_TEST_ASSERT(_overruns([&]() { reader.Read<U32>(); }));
+  CX_TEST_ASSERT(_overruns([&]() { reader.Take<3>(); }));
+  CX_TEST_ASSERT(_overruns([&]() { reader.ReadBytes(3); }));
+  CX_TEST_ASSERT(_overruns([&]() { reader.Split(~size_t(0)); }));
+  CX_TEST_ASSERT(_overruns([&]() { reader.Seek(9); }));
+
+  // failures don't move the reader
+  CX_TEST_ASSERT(reader.Offset() == 6);
+  CX_TEST_ASSERT(!_overruns([&]() { reader.ReadBE<U16>(); }));
+  CX_TEST_ASSERT(reader.AtEnd());
+  CX_TEST_ASSERT(!_overruns([&]() { reader.ReadBytes(0); }));
+
+  CX::ByteWriter writer(buffer, sizeof(buffer));
+  CX_TEST_ASSERT(!_overruns([&]() { writer.WriteBE<U64>(1); }));
+  CX_TEST_ASSERT(_overruns([&]() { writer.Write<U8>(1); }));
+  CX_TEST_ASSERT(_overruns([&]() { writer.WriteString("x"); }));
+  writer.Seek(4);
+  CX_TEST_ASSERT(_overruns([&]() { writer.Take<5>(); }));
+  CX_TEST_ASSERT(writer.Offset() == 4);
+  CX_TEST_ASSERT(buffer[7] == 1);
+CX_ENDFUNCTION
+
+
+CX_FUNCTION(void Test_MAPPED)
+  printf("Testing mapped files...\n");
+
+  char path[] = "/tmp/cx-endianio-XXXXXX";
+  int fd = mkstemp(path);
+  CX_TEST_ASSERT(fd >= 0);
+
+  U8 bytes[] = { 0, 0, 0, 42, 'a', 'b', 'c' };
+  CX_TEST_ASSERT(write(fd, bytes, sizeof(bytes)) == sizeof(bytes));
+  close(fd);
+
+  CX::MappedFileResult opened = CX::MappedFile::Open(path);
+  CX_TEST_ASSERT(opened.Ok());
+  CX::MappedFile file = std::move(opened).Value();
+  CX_TEST_ASSERT(file.Bytes().size() == sizeof(bytes));
+
+  CX::ByteReader reader(file.Bytes());
+  CX_TEST_ASSERT(reader.ReadBE<U32>() == 42);
+  CX_TEST_ASSERT(reader.ReadString(3) == "abc");
+
+  // moved, the mapping goes along
+  CX::MappedFile moved(std::move(file));
+  CX_TEST_ASSERT(file.Bytes().empty());
+  CX_TEST_ASSERT(moved.Bytes().View().substr(4) == "abc");
+
+  // empty files map to nothing
+  CX_TEST_ASSERT(truncate(path, 0) == 0);
+  CX::MappedFileResult empty = CX::MappedFile::Open(path);
+  CX_TEST_ASSERT(empty.Ok() && empty.Value().Bytes().empty());
+  unlink(path);
+
+  CX::MappedFileResult missing = CX::MappedFile::Open(path);
+  CX_TEST_ASSERT(!missing.Ok());
+  CX_TEST_ASSERT(missing.Error().What() == CX::BytesError::MAP);
+CX_ENDFUNCTION
+
+
+int main(int argc, char** argv)
+{
+  Test_STREAM();
+  Test_WINDOWS();
+  Test_BOUNDS();
+  Test_MAPPED();
+
+  exit(EXIT_SUCCESS);
+}
@@ -0,0 +1,226 @@
+// vim: set tabstop=2 softtabstop=2 shiftwidth=2 expandtab :
+/*
+ * Copyright (c) 2026, Ryan V. Bissell
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ * See the enclosed "LICENSE" file for exact license terms.
+ */
+
+#include "cx-test-support.hpp"
+#include "cx-exceptions.hpp"
+
+#include <iterator>
+#include <string>
+
+
+static_assert(sizeof(CX::Exception) <= 512,
+              "exceptions should stay cheap to throw and to copy");
+
+
+// an exception family of our own, derived from CX::Exception
+namespace Widget
+{
+  #define WIDGET_EXCEPTIONS                                           \
+    X(NONE,     "Nothing wrong with the widget.")                     \
+    X(JAMMED,   "The widget is jammed.")                              \
+    X(MISSING,  "There is no widget.")
+
+  #define X(v,str) v,
+  enum class Error: U32
+  {
+    WIDGET_EXCEPTIONS
+  };
+  #undef X
+
+  #define X(v,str) { Error::v, "WidgetError::" #v, str },
+  CX_DECLARE_EXCEPTION_CODES(Error, WIDGET_EXCEPTIONS);
+  #undef X
+
+  CX_DECLARE_EXCEPTION_CLASS(Exception, Error, CX::Exception);
+}
+
+static_assert(std::size(CX::exception_codes<Widget::Error>()) == 3);
+static_assert(CX::find_exception_code(Widget::Error::MISSING)->why[0]
+              == 'T');
+
+
+CX_FUNCTION(void throw_numbers, int i, double d)
+  CX_THROW(CX::Exception, CX::Error::NONE, "i=%d d=%.1f c=%c", i, d, 'x');
+CX_ENDFUNCTION
+
+
+CX_FUNCTION(void throw_temporary, int n)
+  // the string dies during unwinding; its text must not
+  std::string text(n, 'z');
+  CX_THROW(CX::Exception, CX::Error::NONE, "[%s|%s]",
+           text.c_str(), (char const*)nullptr);
+CX_ENDFUNCTION
+
+
+CX_FUNCTION(void throw_wide, int n)
+  // as above, for the other kinds of string printf() takes
+  std::wstring wide(n, L'w');
+  unsigned char bytes[] = { 'u', 'c', 0 };
+  signed char sbytes[] = { 's', 'c', 0 };
+  CX_THROW(CX::Exception, CX::Error::NONE, "[%s|%ls|%s]",
+           bytes, wide.c_str(), sbytes);
+CX_ENDFUNCTION
+
+
+CX_FUNCTION(void Test_LAZY)
+  printf("Testing lazily-formatted reasons...\n");
+
+  CX_TRY
+    throw_numbers(-7, 2.5);
+  CX_CATCH(CX::Exception& e)
+    CX_TEST_ASSERT(!strcmp(e.Reason(), "i=-7 d=2.5 c=x"));
+    CX_TEST_ASSERT(e.Reason() == e.Reason());   // formatted just once
+    CX_TEST_ASSERT(e.Who() != nullptr);
+    CX_TEST_ASSERT(!strncmp(e.Where(), "exceptions.cpp:", 15));
+  CX_ENDTRY
+
+  CX::Exception none("who", "where");
+  CX_TEST_ASSERT(none.Reason() == nullptr);
+  CX_TEST_ASSERT(!strcmp(none.Why(), "Something ineffable happened."));
+CX_ENDFUNCTION
+
+
+CX_FUNCTION(void Test_STRINGS)
+  printf("Testing captured string arguments...\n");
+
+  CX_TRY
+    throw_temporary(40);
+  CX_CATCH(CX::Exception& e)
+    std::string expected = "[" + std::string(40, 'z') + "|(null)]";
+    CX_TEST_ASSERT(e.Reason() == expected);
+  CX_ENDTRY
+
+  CX_TRY
+    throw_wide(5);
+  CX_CATCH(CX::Exception& e)
+    CX_TEST_ASSERT(!strcmp(e.Reason(), "[uc|wwwww|sc]"));
+  CX_ENDTRY
+CX_ENDFUNCTION
+
+
+CX_FUNCTION(void Test_EAGER)
+  printf("Testing reasons too big to capture...\n");
+
+  CX_TRY
+    throw_temporary(1000);
+  CX_CATCH(CX::Exception& e)
+    // formatted at the throw site, and truncated to fit
+    std::string reason = e.Reason();
+    CX_TEST_ASSERT(reason.size() == CX_EXCEPTIONARGSIZE - 1);
+    CX_TEST_ASSERT(reason == "[" + std::string(reason.size() - 1, 'z'));
+  CX_ENDTRY
+CX_ENDFUNCTION
+
+
+CX_FUNCTION(void Test_COPY)
+  printf("Testing copies of exceptions...\n");
+
+  CX::Exception* copy = nullptr;
+  CX_TRY
+    throw_numbers(1, 0.5);
+  CX_CATCH(CX::Exception& e)
+    copy = new CX::Exception(e);
+    CX_TEST_ASSERT(copy->Reason() != e.Reason());
+  CX_ENDTRY
+
+  CX_TEST_ASSERT(!strcmp(copy->Reason(), "i=1 d=0.5 c=x"));
+
+  static char const* who = "who";
+  CX::Exception assigned(who, "where");
+  assigned = *copy;
+  CX_TEST_ASSERT(assigned.Who() != who);
+  delete copy;
+  CX_TEST_ASSERT(!strcmp(assigned.Reason(), "i=1 d=0.5 c=x"));
+CX_ENDFUNCTION
+
+
+CX_FUNCTION(void Test_CODES)
+  printf("Testing exception code tables...\n");
+
+  CX_TRY
+    CX_THROW(Widget::Exception, Widget::Error::JAMMED, "by %s", "cheese");
+  CX_CATCH(CX::Exception& e)
+    CX_TEST_ASSERT(!strcmp(e.Name(), "WidgetError::JAMMED"));
+    CX_TEST_ASSERT(!strcmp(e.Why(), "The widget is jammed."));
+    CX_TEST_ASSERT(!strcmp(e.Reason(), "by cheese"));
+  CX_ENDTRY
+
+  CX::Exception plain("who", "where");
+  CX_TEST_ASSERT(!strcmp(plain.Name(), "CXError::NONE"));
+
+  // codes that the family doesn't know of have no name
+  Widget::Exception bogus("who", "where", Widget::Error(42));
+  CX_TEST_ASSERT(bogus.Name() == nullptr);
+  CX_TEST_ASSERT(bogus.Why() == nullptr);
+
+  U32 count = 0;
+  for (auto const& code : CX::exception_codes<Widget::Error>())
+  {
+    CX_TEST_ASSERT(static_cast<U32>(code.what) == count++);
+    CX_TEST_ASSERT(!strncmp(code.name, "WidgetError::", 13));
+  }
+  CX_TEST_ASSERT(count == 3);
+CX_ENDFUNCTION
+
+
+#ifdef CX_OPT_THROWSTACK
+void stack_thrower(int n) __attribute__((noinline));
+
+CX_FUNCTION(void stack_thrower, int n)
+  CX_THROW(CX::Exception, CX::Error::NONE, "n=%d", n);
+CX_ENDFUNCTION
+
+
+CX_FUNCTION(void Test_STACK)
+  printf("Testing captured stacks...\n");
+
+  CX_TRY
+    stack_thrower(1);
+  CX_CATCH(CX::Exception& e)
+    CX_TEST_ASSERT(e.StackDepth() > 1);
+    CX_TEST_ASSERT(e.StackDepth() <= CX_THROWSTACKDEPTH);
+
+    CX::Exception copy(e);
+    CX_TEST_ASSERT(copy.StackDepth() == e.StackDepth());
+    CX_TEST_ASSERT(copy.StackFrame(0) == e.StackFrame(0));
+
+    // symbolized only now, via dladdr(); that needs -rdynamic, and
+    // still can't name local symbols (such as '.cold' clones.)
+    FILE* file = tmpfile();
+    e.PrintStack(file);
+    rewind(file);
+    char line[512];
+    U32 lines = 0;
+    bool named = false;
+    while (fgets(line, sizeof(line), file))
+    {
+      CX_TEST_ASSERT(atoi(strchr(line, '#') + 1) == (int)lines++);
+      named = named || strstr(line, "Test_STACK");
+    }
+    fclose(file);
+    CX_TEST_ASSERT(lines == e.StackDepth());
+    CX_TEST_ASSERT(named);
+  CX_ENDTRY
+CX_ENDFUNCTION
+#endif
+
+
+int main(int argc, char** argv)
+{
+  Test_LAZY();
+  Test_STRINGS();
+  Test_EAGER();
+  Test_COPY();
+  Test_CODES();
+#ifdef CX_OPT_THROWSTACK
+  Test_STACK();
+#endif
+
+  exit(EXIT_SUCCESS);
+}
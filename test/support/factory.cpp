@@ -12,12 +12,21 @@
 #include "cx-factory.hpp"
 
 #include <string.h>
+#include <atomic>
 #include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <variant>
+#include <vector>
 
 class TestBase
 {
   public:
     TestBase() {};
+    virtual ~TestBase() {}
     virtual std::string Text() = 0;
 };
 
@@ -42,8 +51,705 @@ class TEST2Class: public TestBase
 };
 
 
+// counts what reaches the heap, from behind an arena or pool
+class CountingResource: public std::pmr::memory_resource
+{
+  public:
+    size_t allocations = 0;
+    size_t live = 0;
+
+  private:
+    void* do_allocate(size_t size, size_t align) override
+    {
+      ++allocations;
+      ++live;
+      return std::pmr::new_delete_resource()->allocate(size, align);
+    }
+
+    void do_deallocate(void* memory, size_t size, size_t align) override
+    {
+      --live;
+      std::pmr::new_delete_resource()->deallocate(memory, size, align);
+    }
+
+    bool do_is_equal(memory_resource const& other) const noexcept override
+    {
+      return this == &other;
+    }
+};
+
+
+static int g_destroyed = 0;
+
+class Test3Class: public TestBase
+{
+  public:
+    Test3Class(const std::string& text): TestBase(), text_(text) {}
+    ~Test3Class() { ++g_destroyed; }
+    std::string Text() { return std::string("test3: ") + text_; }
+
+  private:
+    alignas(32) std::string text_;
+};
+
+
+void Test_ARENA()
+{
+  printf("Testing AllocFactory with an arena...\n");
+
+  alignas(64) char buffer[4096];
+  CountingResource upstream;
+  {
+    CX::AllocFactory<TestBase, uint32_t, CX::ArenaPolicy, std::string>
+      factory(buffer, sizeof(buffer), &upstream);
+    factory.Define<Test1Class>(1);
+    factory.Define<Test3Class>(3);
+    CX_TEST_ASSERT(!factory.Define<Test1Class>(1));
+    CX_TEST_ASSERT(!factory.New(2, "nothing"));
+
+    g_destroyed = 0;
+    for (int i = 0; i < 10; ++i)
+    {
+      auto one = factory.New(1, "plugh");
+      auto three = factory.New(3, "xyzzy");
+      CX_TEST_ASSERT(one->Text() == "test1: plugh");
+      CX_TEST_ASSERT(three->Text() == "test3: xyzzy");
+      CX_TEST_ASSERT(((uintptr_t)three.get() % alignof(Test3Class)) == 0);
+      CX_TEST_ASSERT((char*)one.get() >= buffer);
+    }
+    CX_TEST_ASSERT(g_destroyed == 10);
+
+    // all of that fit in the caller's buffer
+    CX_TEST_ASSERT(upstream.allocations == 0);
+
+    std::vector<decltype(factory)::Handle> many;
+    for (int i = 0; i < 100; ++i)
+      many.push_back(factory.New(1, "overflow"));
+    CX_TEST_ASSERT(upstream.allocations > 0);
+
+    many.clear();
+    factory.Policy().Release();
+    CX_TEST_ASSERT(upstream.live == 0);
+  }
+}
+
+
+void Test_POOL()
+{
+  printf("Testing AllocFactory with a pool...\n");
+
+  CountingResource upstream;
+  CX::AllocFactory<TestBase, uint32_t, CX::PoolPolicy, std::string>
+    factory(&upstream);
+  factory.Define<Test1Class>(1);
+
+  for (int i = 0; i < 1000; ++i)
+  {
+    auto one = factory.New(1, "plugh");
+    CX_TEST_ASSERT(one->Text() == "test1: plugh");
+  }
+
+  // freed objects were recycled, rather than going back upstream
+  CX_TEST_ASSERT(upstream.allocations < 10);
+
+  CX::AllocFactory<TestBase, uint32_t, CX::HeapPolicy, std::string>
+    heap;
+  heap.Define<Test3Class>(3);
+  g_destroyed = 0;
+  heap.New(3, "xyzzy").reset();
+  CX_TEST_ASSERT(g_destroyed == 1);
+}
+
+
+// whose hashes collide in pairs, which no perfect hash can separate
+struct Paired
+{
+  uint32_t value;
+
+  bool operator==(Paired const& other) const
+  {
+    return value == other.value;
+  }
+};
+
+namespace std
+{
+  template<>
+  struct hash<Paired>
+  {
+    size_t operator()(Paired const& key) const
+    {
+      return key.value / 2;
+    }
+  };
+}
+
+
+void Test_FROZEN()
+{
+  printf("Testing FrozenFactory...\n");
+
+  typedef CX::Factory<TestBase, std::string, std::string> StringFactory;
+  typedef CX::FrozenFactory<TestBase, std::string, std::string> Frozen;
+
+  // a few keys (searched linearly) and many (perfectly hashed)
+  for (int count : { 3, 500 })
+  {
+    StringFactory factory;
+    for (int i = 0; i < count; ++i)
+    {
+      std::string key = "key-" + std::to_string(i);
+      if (i % 2)
+        factory.Define<Test1Class>(key);
+      else
+        factory.Define<TEST2Class>(key);
+    }
+
+    Frozen frozen(factory);
+    CX_TEST_ASSERT(frozen.size() == (size_t)count);
+
+    for (int i = 0; i < count; ++i)
+    {
+      std::string key = "key-" + std::to_string(i);
+      std::string_view view(key);
+      CX_TEST_ASSERT(frozen.Contains(view));
+
+      std::unique_ptr<TestBase> object(frozen.New(view, "plugh"));
+      CX_TEST_ASSERT(object->Text() ==
+                     std::string((i % 2) ? "test1" : "TEST2") + ": plugh");
+    }
+
+    CX_TEST_ASSERT(!frozen.Contains("key-"));
+    CX_TEST_ASSERT(!frozen.Contains(std::string_view("key-1x", 6)));
+    CX_TEST_ASSERT(frozen.New("nothing", "plugh") == nullptr);
+
+    size_t hash = Frozen::Hash("key-1");
+    std::unique_ptr<TestBase> hashed(frozen.NewHashed("key-1", hash,
+                                                      "xyzzy"));
+    CX_TEST_ASSERT(hashed->Text() == "test1: xyzzy");
+  }
+
+  CX::Factory<TestBase, uint32_t, std::string> numbers;
+  for (uint32_t i = 0; i < 100; ++i)
+    numbers.Define<Test1Class>(i * 1000);
+  CX::FrozenFactory<TestBase, uint32_t, std::string> frozen(numbers);
+  for (uint32_t i = 0; i < 100; ++i)
+    CX_TEST_ASSERT(frozen.Contains(i * 1000));
+  CX_TEST_ASSERT(!frozen.Contains(1U));
+
+  // colliding hashes are searched for, rather than perfectly hashed
+  CX::Factory<TestBase, Paired, std::string> paired;
+  for (uint32_t i = 0; i < 100; ++i)
+    paired.Define<Test1Class>(Paired{ i });
+  CX::FrozenFactory<TestBase, Paired, std::string> collided(paired);
+  for (uint32_t i = 0; i < 100; ++i)
+    CX_TEST_ASSERT(collided.Contains(Paired{ i }));
+  CX_TEST_ASSERT(!collided.Contains(Paired{ 100 }));
+  std::unique_ptr<TestBase> object(collided.New(Paired{ 51 }, "plugh"));
+  CX_TEST_ASSERT(object->Text() == "test1: plugh");
+}
+
+
+// counts its copies, so that forwarding can be shown not to make any
+struct Counted
+{
+  static int copies;
+
+  std::string text;
+
+  Counted(char const* value): text(value) {}
+  Counted(Counted const& other): text(other.text) { ++copies; }
+  Counted(Counted&& other) = default;
+};
+
+int Counted::copies = 0;
+
+class Test4Class: public TestBase
+{
+  public:
+    Test4Class(std::unique_ptr<std::string> text, Counted counted)
+      : TestBase(), text_(std::move(text)), counted_(std::move(counted)) {}
+    std::string Text() { return "test4: " + *text_ + counted_.text; }
+
+  private:
+    std::unique_ptr<std::string> text_;
+    Counted counted_;
+};
+
+
+void Test_FORWARD()
+{
+  printf("Testing Factory's forwarding, and NewAt()...\n");
+
+  typedef CX::Factory<TestBase, uint32_t,
+                      std::unique_ptr<std::string>, Counted> MoveFactory;
+  MoveFactory factory;
+  factory.Define<Test4Class>(4);
+
+  // a move-only parameter gets through, and a copyable one is moved
+  Counted::copies = 0;
+  std::unique_ptr<TestBase> object(
+    factory.New(4, std::make_unique<std::string>("plugh"), "!"));
+  CX_TEST_ASSERT(object->Text() == "test4: plugh!");
+
+  Counted counted("?");
+  object.reset(factory.New(4, std::make_unique<std::string>("xyzzy"),
+                           std::move(counted)));
+  CX_TEST_ASSERT(object->Text() == "test4: xyzzy?");
+  CX_TEST_ASSERT(Counted::copies == 0);
+
+  CX::FrozenFactory<TestBase, uint32_t,
+                    std::unique_ptr<std::string>, Counted> frozen(factory);
+  object.reset(frozen.New(4U, std::make_unique<std::string>("plover"),
+                          "."));
+  CX_TEST_ASSERT(object->Text() == "test4: plover.");
+  CX_TEST_ASSERT(Counted::copies == 0);
+
+  // reference parameters aren't copied either
+  CX::Factory<TestBase, uint32_t, std::string const&> byref;
+  byref.Define<Test1Class>(1);
+  std::string text("plugh");
+  object.reset(byref.New(1, text));
+  CX_TEST_ASSERT(object->Text() == "test1: plugh");
+
+  // an lvalue, for a by-value parameter, is copied just once
+  Counted kept("#");
+  object.reset(factory.New(4, std::make_unique<std::string>("y2"), kept));
+  CX_TEST_ASSERT(object->Text() == "test4: y2#");
+  CX_TEST_ASSERT(Counted::copies == 1);
+
+  // and definitions can be called directly, with const lvalues too
+  CX::Factory<TestBase, uint32_t, std::string> byvalue;
+  byvalue.Define<Test1Class>(1);
+  std::string const word("xyzzy");
+  for (auto iter = byvalue.cbegin(); iter != byvalue.cend(); ++iter)
+  {
+    object.reset((iter->second)(word));
+    CX_TEST_ASSERT(object->Text() == "test1: xyzzy");
+  }
+
+  // in-place construction, into storage the caller provides; which is
+  // more than sizeof(Test4Class), with CX_OPT_FACTORYSTATS
+  typedef CX::FactoryProduct<Test4Class> Test4Product;
+  CX::FactoryLayout layout = factory.Layout(4);
+  CX_TEST_ASSERT(layout.size == sizeof(Test4Product));
+  CX_TEST_ASSERT(layout.align == alignof(Test4Product));
+  CX_TEST_ASSERT(factory.Layout(5).size == 0);
+  CX_TEST_ASSERT(frozen.Layout(4U).size == layout.size);
+
+  alignas(std::max_align_t) char storage[sizeof(Test4Product)];
+  CX_TEST_ASSERT(layout.size <= sizeof(storage));
+  TestBase* placed =
+    factory.NewAt(4, storage, std::make_unique<std::string>("foo"), "");
+  CX_TEST_ASSERT((void*)placed == (void*)storage);
+  CX_TEST_ASSERT(placed->Text() == "test4: foo");
+  placed->~TestBase();
+
+  placed = frozen.NewAt(4U, storage,
+                        std::make_unique<std::string>("bar"), "");
+  CX_TEST_ASSERT(placed->Text() == "test4: bar");
+  placed->~TestBase();
+
+  CX_TEST_ASSERT(!factory.NewAt(5, storage, nullptr, ""));
+}
+
+
+void Test_CONCURRENT()
+{
+  printf("Testing ConcurrentFactory...\n");
+
+  enum { KEYS = 1000, READERS = 4 };
+  CX::ConcurrentFactory<TestBase, uint32_t, std::string> factory;
+  CX_TEST_ASSERT(factory.Define<Test1Class>(0));
+  CX_TEST_ASSERT(!factory.Define<TEST2Class>(0));
+
+  // readers create from whatever keys are defined so far, while the
+  // keys are being defined (and some undefined again)
+  std::atomic<bool> done(false);
+  std::atomic<size_t> created(0);
+  std::atomic<size_t> wrong(0);
+  std::vector<std::thread> readers;
+  for (int r = 0; r < READERS; ++r)
+  {
+    readers.emplace_back([&]()
+    {
+      while (!done.load())
+      {
+        for (uint32_t key = 0; key < KEYS; key += 7)
+        {
+          std::unique_ptr<TestBase> object(factory.New(key, "plugh"));
+          if (!object)
+            continue;
+          ++created;
+          if (object->Text() !=
+              std::string((key % 2) ? "TEST2" : "test1") + ": plugh")
+            ++wrong;
+        }
+      }
+    });
+  }
+
+  for (uint32_t key = 1; key < KEYS; ++key)
+  {
+    bool defined = (key % 2) ? factory.Define<TEST2Class>(key)
+                             : factory.Define<Test1Class>(key);
+    CX_TEST_ASSERT(defined);
+    if ((key % 10) == 0)
+      CX_TEST_ASSERT(factory.Undefine(key / 2));
+  }
+  CX_TEST_ASSERT(!factory.Undefine(KEYS));
+
+  done = true;
+  for (auto& reader : readers)
+    reader.join();
+
+  CX_TEST_ASSERT(created.load() > 0);
+  CX_TEST_ASSERT(wrong.load() == 0);
+  CX_TEST_ASSERT(factory.size() == KEYS - ((KEYS - 1) / 10));
+
+  // with the readers gone, every old snapshot can be freed
+  CX_TEST_ASSERT(factory.Pending() == 0);
+
+  size_t visited = 0;
+  factory.Visit([&](decltype(factory)::Snapshot const& snapshot)
+                {
+                  for (auto i = snapshot.cbegin(); i != snapshot.cend(); ++i)
+                    ++visited;
+                });
+  CX_TEST_ASSERT(visited == factory.size());
+
+  CX::FactoryLayout layout = factory.Layout(1);
+  CX_TEST_ASSERT(layout.size == sizeof(CX::FactoryProduct<TEST2Class>));
+
+  // miss hooks replaced while readers are calling them; each
+  // SetMissHook() waits for those, so what a hook uses can then go
+  done = false;
+  readers.clear();
+  for (int r = 0; r < READERS; ++r)
+  {
+    readers.emplace_back([&]()
+    {
+      while (!done.load())
+        CX_TEST_ASSERT(!factory.New(KEYS + 1, "xyzzy"));
+    });
+  }
+
+  for (int round = 0; round < 100; ++round)
+  {
+    auto misses = std::make_unique<std::atomic<size_t>>(0);
+    factory.SetMissHook([counted = misses.get()](uint32_t const&)
+                        {
+                          ++*counted;
+                          return false;
+                        });
+    while (misses->load() < READERS)
+      std::this_thread::yield();
+    factory.SetMissHook(nullptr);
+  }
+
+  done = true;
+  for (auto& reader : readers)
+    reader.join();
+}
+
+
+// throws from its constructor once 'g_throwafter' objects are built
+static int g_throwafter = -1;
+
+class Test5Class: public TestBase
+{
+  public:
+    Test5Class(const std::string& text): TestBase(), text_(text)
+    {
+      if (g_throwafter == 0)
+        throw std::runtime_error("Test5Class");
+      --g_throwafter;
+    }
+    ~Test5Class() { ++g_destroyed; }
+    std::string Text() { return std::string("test5: ") + text_; }
+
+  private:
+    std::string text_;
+};
+
+
+void Test_BATCH()
+{
+  printf("Testing Factory::NewBatch()...\n");
+
+  CX::Factory<TestBase, uint32_t, std::string> factory;
+  factory.Define<Test1Class>(1);
+  factory.Define<Test3Class>(3);
+  factory.Define<Test5Class>(5);
+
+  g_destroyed = 0;
+  {
+    CX::FactoryBatch<TestBase> batch = factory.NewBatch(3, 100, "plugh");
+    CX_TEST_ASSERT(batch.size() == 100);
+    CX_TEST_ASSERT(batch.Stride() == sizeof(CX::FactoryProduct<Test3Class>));
+    CX_TEST_ASSERT(((uintptr_t)batch[0] % 64) == 0);
+
+    // one block, the objects side by side
+    size_t count = 0;
+    for (TestBase* object : batch)
+    {
+      CX_TEST_ASSERT(object == batch[count]);
+      CX_TEST_ASSERT((char*)object ==
+                     (char*)batch[0] + (count * batch.Stride()));
+      CX_TEST_ASSERT(object->Text() == "test3: plugh");
+      ++count;
+    }
+    CX_TEST_ASSERT(count == 100);
+
+    CX::FactoryBatch<TestBase> moved(std::move(batch));
+    CX_TEST_ASSERT(batch.empty() && (moved.size() == 100));
+    CX_TEST_ASSERT(g_destroyed == 0);
+  }
+  CX_TEST_ASSERT(g_destroyed == 100);
+
+  CX_TEST_ASSERT(factory.NewBatch(2, 10, "nothing").empty());
+  CX_TEST_ASSERT(factory.NewBatch(1, 0, "nothing").empty());
+
+  // too many to fit, which mustn't wrap around to a few
+  CX_TEST_ASSERT(factory.NewBatch(1, SIZE_MAX / 2, "nothing").empty());
+  CX_TEST_ASSERT(factory.NewBatch(1, SIZE_MAX, "nothing").empty());
+  size_t wraps = (SIZE_MAX / sizeof(CX::FactoryProduct<Test1Class>)) + 2;
+  CX_TEST_ASSERT(factory.NewBatch(1, wraps, "nothing").empty());
+
+  // a constructor that throws part way takes down what was built
+  g_destroyed = 0;
+  g_throwafter = 4;
+  bool thrown = false;
+  try {
+    factory.NewBatch(5, 10, "xyzzy");
+  } catch (std::runtime_error const&) {
+    thrown = true;
+  }
+  CX_TEST_ASSERT(thrown && (g_destroyed == 4));
+  g_throwafter = -1;
+
+  CX::FrozenFactory<TestBase, uint32_t, std::string> frozen(factory);
+  CX::FactoryBatch<TestBase> batch = frozen.NewBatch(1U, 3, "foo");
+  CX_TEST_ASSERT((batch.size() == 3) && (batch[2]->Text() == "test1: foo"));
+
+  // nothing can be copied from a unique_ptr; so no batches
+  CX::Factory<TestBase, uint32_t,
+              std::unique_ptr<std::string>, Counted> moveonly;
+  moveonly.Define<Test4Class>(4);
+  CX_TEST_ASSERT(moveonly.NewBatch(4, 10, nullptr, "").empty());
+}
+
+
+// can be reused in place, through its Reset() hook
+static int g_constructed = 0;
+
+class Test6Class: public TestBase
+{
+  public:
+    Test6Class(const std::string& text): TestBase(), text_(text)
+    {
+      ++g_constructed;
+    }
+    void Reset(const std::string& text) { text_ = text; }
+    std::string Text() { return std::string("test6: ") + text_; }
+
+  private:
+    std::string text_;
+};
+
+
+void Test_RECYCLE()
+{
+  printf("Testing RecyclingFactory...\n");
+
+  CX::RecyclingFactory<TestBase, uint32_t, std::string> factory(4);
+  factory.Define<Test3Class>(3);
+  factory.Define<Test6Class>(6);
+  factory.Define<Test6Class>(66);
+  CX_TEST_ASSERT(!factory.Define<Test1Class>(3));
+
+  // without a Reset(), the object is reconstructed where it was
+  g_destroyed = 0;
+  TestBase* first = factory.New(3, "plugh");
+  factory.Recycle(first);
+  CX_TEST_ASSERT(g_destroyed == 0);
+  TestBase* second = factory.New(3, "xyzzy");
+  CX_TEST_ASSERT(second == first);
+  CX_TEST_ASSERT(g_destroyed == 1);
+  CX_TEST_ASSERT(second->Text() == "test3: xyzzy");
+  delete second;
+
+  // with one, it is reset instead; and keys of a class share a cache
+  g_constructed = 0;
+  first = factory.New(6, "plugh");
+  factory.Recycle(first);
+  second = factory.New(66, "xyzzy");
+  CX_TEST_ASSERT(second == first);
+  CX_TEST_ASSERT(g_constructed == 1);
+  CX_TEST_ASSERT(second->Text() == "test6: xyzzy");
+
+  // at most 'capacity' are kept
+  std::vector<TestBase*> objects;
+  for (int i = 0; i < 6; ++i)
+    objects.push_back(factory.New(6, "plover"));
+  factory.Recycle(second);
+  for (TestBase* object : objects)
+    factory.Recycle(object);
+
+  CX::RecycleStats stats = factory.Stats(6);
+  CX_TEST_ASSERT(stats.hits == 1);
+  CX_TEST_ASSERT(stats.misses == 7);
+  CX_TEST_ASSERT(stats.recycled == 5);
+  CX_TEST_ASSERT(stats.dropped == 3);
+  CX_TEST_ASSERT(stats.HitRate() == 1.0 / 8);
+  CX_TEST_ASSERT(factory.Stats(1).misses == 0);
+
+  // other threads keep caches of their own, and their counts outlast
+  // them; unknown objects are just deleted
+  std::thread([&]()
+              {
+                for (int i = 0; i < 100; ++i)
+                  factory.Recycle(factory.New(3, "foo"));
+                factory.Recycle(new Test1Class("bar"));
+              }).join();
+  std::thread([&]()
+              {
+                factory.Recycle(factory.New(3, "foo"));
+              }).join();
+
+  stats = factory.Stats(3);
+  CX_TEST_ASSERT(stats.hits == 1 + 99);
+  CX_TEST_ASSERT(stats.misses == 1 + 1 + 1);
+  CX_TEST_ASSERT(stats.recycled == 1 + 100 + 1);
+
+  // a factory that dies takes its objects out of the caches of
+  // threads that live on
+  typedef CX::RecyclingFactory<TestBase, uint32_t, std::string> Recycler;
+  std::unique_ptr<Recycler> doomed(new Recycler(4));
+  doomed->Define<Test3Class>(3);
+
+  std::atomic<int> step(0);
+  std::thread keeper([&]()
+                     {
+                       TestBase* one = doomed->New(3, "foo");
+                       TestBase* two = doomed->New(3, "bar");
+                       doomed->Recycle(one);
+                       doomed->Recycle(two);
+                       step = 1;
+                       while (step != 2)
+                         std::this_thread::yield();
+
+                       Recycler later(4);
+                       later.Define<Test3Class>(3);
+                       later.Recycle(later.New(3, "baz"));
+                     });
+  while (step != 1)
+    std::this_thread::yield();
+
+  g_destroyed = 0;
+  doomed.reset();
+  CX_TEST_ASSERT(g_destroyed == 2);
+  step = 2;
+  keeper.join();
+}
+
+
+// a closed set, for VariantFactory; no common base, nothing virtual
+struct Circle
+{
+  static constexpr std::string_view FactoryKey = "circle";
+
+  Circle(double radius): radius(radius) {}
+  double Area() const { return 3.0 * radius * radius; }
+
+  double radius;
+};
+
+struct Square
+{
+  static constexpr std::string_view FactoryKey = "square";
+
+  Square(double side): side(side) {}
+  Square(double width, double height): side(width * height) {}
+  double Area() const { return side * side; }
+
+  double side;
+};
+
+struct Label
+{
+  static constexpr char const* FactoryKey = "label";
+
+  Label(std::string text): text(std::move(text)) {}
+  double Area() const { return 0.0; }
+
+  std::string text;
+};
+
+struct One { static constexpr int FactoryKey = 1; };
+struct Two { static constexpr int FactoryKey = 2; };
+
+
+void Test_VARIANT()
+{
+  printf("Testing VariantFactory...\n");
+
+  typedef CX::VariantFactory<std::string_view, Circle, Square, Label>
+    Shapes;
+
+  // literal keys resolve at compile time
+  static_assert(Shapes::IndexOf("circle") == 0);
+  static_assert(Shapes::IndexOf("label") == 2);
+  static_assert(Shapes::IndexOf("hexagon") == Shapes::npos);
+
+  Shapes::Value square = Shapes::New<Shapes::IndexOf("square")>(2.0);
+  CX_TEST_ASSERT(std::get<Square>(square).side == 2.0);
+  CX_TEST_ASSERT(Shapes::KeyOf(square) == "square");
+
+  // and others, at run time
+  std::vector<Shapes::Value> shapes;
+  std::string key("circle");
+  for (int i = 0; i < 10; ++i)
+  {
+    auto shape = Shapes::New(key, 1.0);
+    CX_TEST_ASSERT(shape.has_value());
+    shapes.push_back(std::move(*shape));
+  }
+  CX_TEST_ASSERT(!Shapes::New("hexagon", 1.0));
+  CX_TEST_ASSERT(!Shapes::New("label", 1.0));
+  CX_TEST_ASSERT(Shapes::New("label", "plugh")->index() == 2);
+
+  CX_TEST_ASSERT(Shapes::Emplace(shapes[0], "square", 2.0, 3.0));
+  CX_TEST_ASSERT(Shapes::Emplace(shapes[1], "label", "xyzzy"));
+  CX_TEST_ASSERT(!Shapes::Emplace(shapes[2], "square", "plover"));
+  CX_TEST_ASSERT(shapes[2].index() == 0);
+
+  double area = 0.0;
+  for (auto const& shape : shapes)
+    area += std::visit([](auto const& s) { return s.Area(); }, shape);
+  CX_TEST_ASSERT(area == (36.0 + (3.0 * 8)));
+  CX_TEST_ASSERT(std::get<Label>(shapes[1]).text == "xyzzy");
+
+  // integral keys work as well
+  typedef CX::VariantFactory<int, One, Two> Numbers;
+  static_assert(Numbers::IndexOf(2) == 1);
+  CX_TEST_ASSERT(Numbers::New(1)->index() == 0);
+  CX_TEST_ASSERT(!Numbers::New(3));
+}
+
+
 int main(int argc, char** argv)
 {
+  Test_FORWARD();
+  Test_FROZEN();
+  Test_CONCURRENT();
+  Test_BATCH();
+  Test_RECYCLE();
+  Test_VARIANT();
+
+  Test_ARENA();
+  Test_POOL();
+
   CX::Factory<TestBase, uint32_t, std::string> testFactory;
 
   testFactory.Define<Test1Class>(1);
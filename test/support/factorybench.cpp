@@ -0,0 +1,333 @@
+// vim: set tabstop=2 softtabstop=2 shiftwidth=2 expandtab :
+
+/*
+ * Copyright (c) 2026, Ryan V. Bissell
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ * See the enclosed "LICENSE" file for exact license terms.
+ */
+
+// Compares Factory's unordered_map lookups with FrozenFactory's, for
+// string keys arriving as string_views (as if off the wire.)  The
+// 'LOOKUP' cases only find the key; the 'NEW' cases also create and
+// destroy a (trivial) object.
+//
+// Next, creating, visiting and destroying 1024 objects of one key,
+// one New() at a time ('EACHNEW') or with one NewBatch() ('BATCHNEW');
+// reported as ns per object.  And the same one at a time, but with
+// each object recycled by a RecyclingFactory ('RECYCLEDNEW'); and
+// made by value in a vector, by a VariantFactory ('VARIANTNEW').
+//
+// Then compares a mutex-guarded Factory with a ConcurrentFactory, as
+// more threads create from them at once; reported as creations per
+// microsecond, over all threads ('LOCKEDNEW' and 'CONCURRENTNEW').
+//
+// Environment:
+//   CX_BENCHMS         minimum milliseconds per measurement (20)
+
+#include "cx-test-support.hpp"
+#include "cx-factory.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <variant>
+#include <vector>
+
+
+class BenchBase
+{
+  public:
+    virtual ~BenchBase() {}
+    virtual int Value() const = 0;
+};
+
+class BenchClass: public BenchBase
+{
+  public:
+    BenchClass(int value): value_(value) {}
+    int Value() const { return value_; }
+
+  private:
+    int value_;
+};
+
+
+// the same, and another, as a closed set
+struct BenchValue
+{
+  static constexpr std::string_view FactoryKey = "batched";
+
+  BenchValue(int value): value(value) {}
+  int Value() const { return value; }
+
+  int value;
+};
+
+struct BenchOther
+{
+  static constexpr std::string_view FactoryKey = "other";
+
+  BenchOther(int value): value(value) {}
+  int Value() const { return -value; }
+
+  int value;
+};
+
+
+typedef CX::Factory<BenchBase, std::string, int> BenchFactory;
+typedef CX::FrozenFactory<BenchBase, std::string, int> BenchFrozen;
+
+static double g_minimum_ns;
+static std::vector<std::string> g_keys;
+static std::vector<std::string_view> g_wire;
+
+
+// runs 'body' over the wire keys until that takes long enough to
+// trust, and returns nanoseconds per key
+template<typename TBody>
+static double
+_time(TBody body)
+{
+  U64 iterations = 1;
+  for (;;)
+  {
+    auto start = std::chrono::steady_clock::now();
+    U64 found = 0;
+    for (U64 i = 0; i < iterations; ++i)
+      for (auto const& key : g_wire)
+        found += body(key);
+    auto stop = std::chrono::steady_clock::now();
+    CX_TEST_ASSERT(found == iterations * g_wire.size());
+
+    std::chrono::duration<double, std::nano> elapsed = stop - start;
+    if ((elapsed.count() >= g_minimum_ns) || (iterations >= (1U << 24)))
+      return elapsed.count() / (iterations * g_wire.size());
+    iterations *= 4;
+  }
+}
+
+
+static void
+_bench(size_t count)
+{
+  g_keys.clear();
+  for (size_t i = 0; i < count; ++i)
+    g_keys.push_back("message.type." + std::to_string(i * 7919));
+
+  // lookups in a scrambled order, a few times over each key
+  g_wire.clear();
+  for (size_t i = 0; i < 1024; ++i)
+    g_wire.push_back(g_keys[(i * 40503) % count]);
+
+  BenchFactory factory;
+  for (auto const& key : g_keys)
+    factory.Define<BenchClass>(key);
+  BenchFrozen frozen(factory);
+
+  // Factory has no lookup of its own, so copy its map for that
+  BenchFactory::FFuncMap map(factory.cbegin(), factory.cend());
+
+  double ns[4];
+  ns[0] = _time([&](std::string_view key)
+                {
+                  return map.find(std::string(key)) != map.end();
+                });
+  ns[1] = _time([&](std::string_view key)
+                {
+                  return frozen.Contains(key);
+                });
+  ns[2] = _time([&](std::string_view key)
+                {
+                  BenchBase* object = factory.New(std::string(key), 1);
+                  int value = object->Value();
+                  delete object;
+                  return value;
+                });
+  ns[3] = _time([&](std::string_view key)
+                {
+                  BenchBase* object = frozen.New(key, 1);
+                  int value = object->Value();
+                  delete object;
+                  return value;
+                });
+
+  char const* names[] =
+    { "MAPLOOKUP", "FROZENLOOKUP", "MAPNEW", "FROZENNEW" };
+  for (int i = 0; i < 4; ++i)
+    fprintf(stderr, "factory,%s,%zu,%.2f\n", names[i], count, ns[i]);
+}
+
+
+static void
+_bench_batch()
+{
+  enum { OBJECTS = 1024 };
+
+  BenchFactory factory;
+  factory.Define<BenchClass>("batched");
+  std::string const key("batched");
+  std::vector<BenchBase*> objects(OBJECTS);
+
+  // _time() calls its body once per wire key
+  g_wire.assign(1, key);
+
+  CX::RecyclingFactory<BenchBase, std::string, int> recycling(OBJECTS);
+  recycling.Define<BenchClass>(key);
+
+  typedef CX::VariantFactory<std::string_view, BenchOther, BenchValue>
+    BenchVariants;
+  std::vector<BenchVariants::Value> values(OBJECTS, BenchOther(0));
+
+  double ns[4];
+  ns[0] = _time([&](std::string_view)
+                {
+                  for (auto& object : objects)
+                    object = factory.New(key, 1);
+                  int total = 0;
+                  for (auto object : objects)
+                    total += object->Value();
+                  for (auto object : objects)
+                    delete object;
+                  return total == OBJECTS;
+                });
+  ns[1] = _time([&](std::string_view)
+                {
+                  auto batch = factory.NewBatch(key, OBJECTS, 1);
+                  int total = 0;
+                  for (auto object : batch)
+                    total += object->Value();
+                  return total == OBJECTS;
+                });
+  ns[2] = _time([&](std::string_view)
+                {
+                  for (auto& object : objects)
+                    object = recycling.New(key, 1);
+                  int total = 0;
+                  for (auto object : objects)
+                    total += object->Value();
+                  for (auto object : objects)
+                    recycling.Recycle(object);
+                  return total == OBJECTS;
+                });
+  ns[3] = _time([&](std::string_view)
+                {
+                  for (auto& value : values)
+                    BenchVariants::Emplace(value, key, 1);
+                  int total = 0;
+                  for (auto const& value : values)
+                    total += std::visit([](auto const& v)
+                                        {
+                                          return v.Value();
+                                        }, value);
+                  return total == OBJECTS;
+                });
+
+  fprintf(stderr, "factory,EACHNEW,%d,%.2f\n", OBJECTS, ns[0] / OBJECTS);
+  fprintf(stderr, "factory,BATCHNEW,%d,%.2f\n", OBJECTS, ns[1] / OBJECTS);
+  fprintf(stderr, "factory,RECYCLEDNEW,%d,%.2f\n",
+          OBJECTS, ns[2] / OBJECTS);
+  fprintf(stderr, "factory,VARIANTNEW,%d,%.2f\n",
+          OBJECTS, ns[3] / OBJECTS);
+
+  CX::RecycleStats stats = recycling.Stats(key);
+  CX_TEST_ASSERT(stats.HitRate() > 0.99);
+}
+
+
+// runs 'body' on 'threads' threads at once, for the minimum time,
+// and returns the total calls per microsecond
+template<typename TBody>
+static double
+_throughput(unsigned threads, TBody body)
+{
+  std::atomic<bool> go(false), stop(false);
+  std::atomic<U64> total(0);
+  std::vector<std::thread> workers;
+  for (unsigned t = 0; t < threads; ++t)
+  {
+    workers.emplace_back([&, t]()
+    {
+      while (!go.load())
+        ;
+      U64 calls = 0;
+      for (size_t i = t; !stop.load(std::memory_order_relaxed);
+           i = (i + 1) % g_keys.size())
+      {
+        body(g_keys[i]);
+        ++calls;
+      }
+      total += calls;
+    });
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  go = true;
+  std::this_thread::sleep_for(
+    std::chrono::duration<double, std::nano>(g_minimum_ns));
+  stop = true;
+  for (auto& worker : workers)
+    worker.join();
+  auto end = std::chrono::steady_clock::now();
+
+  std::chrono::duration<double, std::micro> elapsed = end - start;
+  return total.load() / elapsed.count();
+}
+
+
+static void
+_bench_threads()
+{
+  g_keys.clear();
+  for (size_t i = 0; i < 64; ++i)
+    g_keys.push_back("message.type." + std::to_string(i * 7919));
+
+  BenchFactory locked;
+  std::mutex lock;
+  CX::ConcurrentFactory<BenchBase, std::string, int> concurrent;
+  for (auto const& key : g_keys)
+  {
+    locked.Define<BenchClass>(key);
+    concurrent.Define<BenchClass>(key);
+  }
+
+  unsigned cores = std::max(1U, std::thread::hardware_concurrency());
+  for (unsigned threads = 1; threads <= cores; threads *= 2)
+  {
+    double rate[2];
+    rate[0] = _throughput(threads, [&](std::string const& key)
+                          {
+                            BenchBase* object;
+                            {
+                              std::lock_guard<std::mutex> guard(lock);
+                              object = locked.New(key, 1);
+                            }
+                            delete object;
+                          });
+    rate[1] = _throughput(threads, [&](std::string const& key)
+                          {
+                            delete concurrent.New(key, 1);
+                          });
+
+    fprintf(stderr, "factory,LOCKEDNEW,%u,%.2f\n", threads, rate[0]);
+    fprintf(stderr, "factory,CONCURRENTNEW,%u,%.2f\n", threads, rate[1]);
+  }
+}
+
+
+int main(int argc, char** argv)
+{
+  char const* ms = getenv("CX_BENCHMS");
+  g_minimum_ns = 1e6 * atof((ms && *ms) ? ms : "20");
+
+  for (size_t count : { 4, 8, 64, 1024, 16384 })
+    _bench(count);
+  _bench_batch();
+  _bench_threads();
+
+  exit(EXIT_SUCCESS);
+}
@@ -0,0 +1,235 @@
+// vim: set tabstop=2 softtabstop=2 shiftwidth=2 expandtab :
+/*
+ * Copyright (c) 2026, Ryan V. Bissell
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ * See the enclosed "LICENSE" file for exact license terms.
+ */
+
+#include "cx-test-support.hpp"
+#include "cx-factory.hpp"
+
+#include <stdio.h>
+#include <string.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+
+class StatsBase
+{
+  public:
+    virtual ~StatsBase() {}
+    virtual int Value() const = 0;
+};
+
+class SmallClass: public StatsBase
+{
+  public:
+    SmallClass(int value): value_(value) {}
+    int Value() const { return value_; }
+
+  private:
+    int value_;
+};
+
+class BigClass: public StatsBase
+{
+  public:
+    BigClass(int value) { buffer_[0] = value; }
+    int Value() const { return buffer_[0]; }
+
+  private:
+    int buffer_[256];
+};
+
+// can't be tracked
+class FinalClass final: public StatsBase
+{
+  public:
+    FinalClass(int value): value_(value) {}
+    int Value() const { return value_; }
+
+  private:
+    int value_;
+};
+
+typedef CX::Factory<StatsBase, std::string, int> StatsFactory;
+
+
+void Test_COUNTS()
+{
+  printf("Testing per-key object counts...\n");
+
+  StatsFactory factory;
+  factory.Define<SmallClass>("small");
+  factory.Define<BigClass>("big");
+
+  std::vector<StatsBase*> objects;
+  for (int i = 0; i < 10; ++i)
+    objects.push_back(factory.New("small", i));
+  objects.push_back(factory.New("big", 7));
+  CX_TEST_ASSERT(dynamic_cast<BigClass*>(objects.back()));
+  CX_TEST_ASSERT(objects.back()->Value() == 7);
+
+  CX::FactoryStats::Counts counts = factory.Stats("small");
+  CX_TEST_ASSERT(counts.created == 10);
+  CX_TEST_ASSERT(counts.live == 10);
+  CX_TEST_ASSERT(counts.peak == 10);
+
+  for (int i = 0; i < 4; ++i)
+    delete objects[i];
+
+  counts = factory.Stats("small");
+  CX_TEST_ASSERT(counts.created == 10);
+  CX_TEST_ASSERT(counts.live == 6);
+  CX_TEST_ASSERT(counts.peak == 10);
+  CX_TEST_ASSERT(counts.bytes == 6 * sizeof(SmallClass));
+  CX_TEST_ASSERT(counts.peakbytes == 10 * sizeof(SmallClass));
+
+  counts = factory.Stats("big");
+  CX_TEST_ASSERT((counts.created == 1) && (counts.live == 1));
+  CX_TEST_ASSERT(counts.bytes == sizeof(BigClass));
+
+  // and the same, by iterating
+  size_t keys = 0;
+  for (auto iter = factory.cbegin(); iter != factory.cend(); ++iter)
+  {
+    counts = iter->second.Stats();
+    CX_TEST_ASSERT(counts.live == ((iter->first == "big") ? 1 : 6));
+    ++keys;
+  }
+  CX_TEST_ASSERT(keys == 2);
+
+  // objects outlive their factory's stats; and copies share them
+  StatsFactory copy(factory);
+  for (size_t i = 4; i < objects.size(); ++i)
+    delete objects[i];
+  CX_TEST_ASSERT(copy.Stats("small").live == 0);
+  CX_TEST_ASSERT(copy.Stats("big").live == 0);
+  CX_TEST_ASSERT(factory.Stats("unknown").created == 0);
+}
+
+
+void Test_PLACED()
+{
+  printf("Testing counts of NewAt() and NewBatch() objects...\n");
+
+  StatsFactory factory;
+  factory.Define<SmallClass>("small");
+  factory.Define<FinalClass>("final");
+
+  CX::FactoryLayout layout = factory.Layout("small");
+  CX_TEST_ASSERT(layout.size > sizeof(SmallClass));
+  alignas(std::max_align_t) char storage[64];
+  CX_TEST_ASSERT(layout.size <= sizeof(storage));
+
+  StatsBase* placed = factory.NewAt("small", storage, 3);
+  CX_TEST_ASSERT(placed && (placed->Value() == 3));
+  CX_TEST_ASSERT(factory.Stats("small").live == 1);
+  placed->~StatsBase();
+  CX_TEST_ASSERT(factory.Stats("small").live == 0);
+
+  {
+    auto batch = factory.NewBatch("small", 5, 4);
+    CX_TEST_ASSERT(batch.size() == 5);
+    CX_TEST_ASSERT(batch[4]->Value() == 4);
+    CX_TEST_ASSERT(factory.Stats("small").live == 5);
+  }
+  CX::FactoryStats::Counts counts = factory.Stats("small");
+  CX_TEST_ASSERT((counts.created == 6) && (counts.live == 0));
+  CX_TEST_ASSERT(counts.peak == 5);
+
+  // untracked, so uncounted, and no bigger
+  StatsBase* final = factory.New("final", 5);
+  CX_TEST_ASSERT(final && (final->Value() == 5));
+  CX_TEST_ASSERT(factory.Stats("final").created == 0);
+  CX_TEST_ASSERT(factory.Layout("final").size == sizeof(FinalClass));
+  delete final;
+}
+
+
+void Test_THREADS()
+{
+  printf("Testing counts from many threads...\n");
+
+  enum { THREADS = 4, OBJECTS = 1000 };
+
+  CX::ConcurrentFactory<StatsBase, std::string, int> factory;
+  factory.Define<SmallClass>("small");
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < THREADS; ++t)
+  {
+    threads.emplace_back([&factory]()
+    {
+      std::vector<StatsBase*> objects;
+      for (int i = 0; i < OBJECTS; ++i)
+        objects.push_back(factory.New("small", i));
+      for (auto object : objects)
+        delete object;
+    });
+  }
+  for (auto& thread : threads)
+    thread.join();
+
+  factory.Visit([](StatsFactory const& snapshot)
+  {
+    CX::FactoryStats::Counts counts = snapshot.Stats("small");
+    CX_TEST_ASSERT(counts.created == THREADS * OBJECTS);
+    CX_TEST_ASSERT(counts.live == 0);
+
+    // sampled, but at least once during each thread's last SAMPLE
+    CX_TEST_ASSERT(counts.peak > OBJECTS - CX::FactoryStats::SAMPLE);
+    CX_TEST_ASSERT(counts.peak <= THREADS * OBJECTS);
+  });
+}
+
+
+void Test_REPORT()
+{
+  printf("Testing the stats report...\n");
+
+  StatsFactory factory;
+  factory.Define<SmallClass>("small");
+  factory.Define<BigClass>("big");
+
+  StatsBase* small = factory.New("small", 1);
+  StatsBase* big = factory.New("big", 2);
+
+  FILE* file = tmpfile();
+  CX_TEST_ASSERT(file);
+  factory.Report(file);
+  rewind(file);
+
+  std::vector<std::string> lines;
+  char line[256];
+  while (fgets(line, sizeof(line), file))
+    lines.push_back(line);
+  fclose(file);
+
+  // a header, then most live bytes first
+  CX_TEST_ASSERT(lines.size() == 3);
+  CX_TEST_ASSERT(strstr(lines[0].c_str(), "live-bytes"));
+  CX_TEST_ASSERT(strstr(lines[1].c_str(), "big (BigClass)"));
+  CX_TEST_ASSERT(strstr(lines[2].c_str(), "small (SmallClass)"));
+
+  delete small;
+  delete big;
+
+  // every product so far, for the exit report
+  CX::FactoryStats::report(stdout);
+}
+
+
+int main(int argc, char** argv)
+{
+  Test_COUNTS();
+  Test_PLACED();
+  Test_THREADS();
+  Test_REPORT();
+
+  exit(EXIT_SUCCESS);
+}
@@ -0,0 +1,98 @@
+// vim: set tabstop=2 softtabstop=2 shiftwidth=2 expandtab :
+
+/*
+ * Copyright (c) 2026, Ryan V. Bissell
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ * See the enclosed "LICENSE" file for exact license terms.
+ */
+
+#include "cx-test-support.hpp"
+#include "cx-tracedebug.hpp"
+
+#include <thread>
+
+
+volatile U64 g_sink;
+
+CX_FUNCTION(void spin, U64 n)
+  for (U64 i = 0; i < n; ++i)
+    g_sink = g_sink + i;
+CX_ENDFUNCTION
+
+
+CX_FUNCTION(void outer, U64 n)
+  spin(n);
+  spin(n);
+CX_ENDFUNCTION
+
+
+void Test_SOURCE()
+{
+  CX::Perf::Source source = CX::Perf::get_source();
+
+  printf("Counting with '%s'...\n",
+         CX::Perf::get_slot_name(source, 0));
+  CX_TEST_ASSERT(source != CX::Perf::Source::NONE);
+
+  char const* want = getenv("CX_PERFSOURCE");
+  if (want && !strcmp(want, "clock"))
+    CX_TEST_ASSERT(source == CX::Perf::Source::CLOCK);
+  if (want && !strcmp(want, "software"))
+    CX_TEST_ASSERT(source != CX::Perf::Source::HARDWARE);
+}
+
+
+void Test_AGGREGATION()
+{
+  CX::Perf::Stats spin, outer;
+
+  printf("Testing per-method aggregation...\n");
+  CX::Perf::reset();
+
+  for (int i = 0; i < 10; ++i)
+    ::outer(100000);
+
+  CX_TEST_ASSERT(CX::Perf::get_stats("void outer", outer));
+  CX_TEST_ASSERT(CX::Perf::get_stats("void spin", spin));
+  CX_TEST_ASSERT(outer.calls == 10);
+  CX_TEST_ASSERT(spin.calls == 20);
+
+  // scopes are inclusive, so the caller can't count less
+  CX_TEST_ASSERT(outer.total.value[0] >= spin.total.value[0]);
+}
+
+
+void Test_THREADS()
+{
+  CX::Perf::Stats spin;
+
+  printf("Testing aggregation across threads...\n");
+  CX::Perf::reset();
+
+  CX::Perf::Source other = CX::Perf::Source::NONE;
+  std::thread t1([]{ ::spin(1000); ::spin(1000); });
+  std::thread t2([&]{ ::spin(1000); other = CX::Perf::get_source(); });
+  t1.join();
+  t2.join();
+  ::spin(1000);
+
+  // every thread counts in the units the process settled on
+  CX_TEST_ASSERT(other == CX::Perf::get_source());
+
+  CX_TEST_ASSERT(CX::Perf::get_stats("void spin", spin));
+  CX_TEST_ASSERT(spin.calls == 4);
+}
+
+
+int main(int argc, char** argv)
+{
+  Test_SOURCE();
+  Test_AGGREGATION();
+  Test_THREADS();
+
+  CX::Perf::report(stdout);
+
+  exit(EXIT_SUCCESS);
+}
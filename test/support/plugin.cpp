@@ -0,0 +1,139 @@
+// vim: set tabstop=2 softtabstop=2 shiftwidth=2 expandtab :
+/*
+ * Copyright (c) 2026, Ryan V. Bissell
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ * See the enclosed "LICENSE" file for exact license terms.
+ */
+
+// Loads pluginsample (a shared object, named by CX_PLUGINSAMPLE)
+// directly, and then lazily, through a scanned directory.
+
+#include "cx-test-support.hpp"
+#include "cx-plugin.hpp"
+#include "plugin.hpp"
+
+#include <limits.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <fstream>
+#include <memory>
+#include <string>
+
+
+static char g_sample[PATH_MAX];
+
+
+static void
+_write(std::string const& path, char const* text)
+{
+  std::ofstream file(path);
+  file << text;
+  CX_TEST_ASSERT(file.good());
+}
+
+
+CX_FUNCTION(void Test_LOAD)
+  printf("Testing PluginLoader::Load()...\n");
+
+  WordFactory words;
+  NumberFactory numbers;
+  CX::PluginLoader loader;    // which they outlive
+  loader.Publish("words", words);
+
+  // the plugin can't find all of its factories, so refuses to load
+  CX::PluginResult result = loader.Load(g_sample);
+  CX_TEST_ASSERT(!result.Ok());
+  CX_TEST_ASSERT(result.Error().What() == CX::PluginError::REJECTED);
+
+  // and that isn't a plugin at all
+  result = loader.Load("/nonexistent/plugin.so");
+  CX_TEST_ASSERT(result.Error().What() == CX::PluginError::OPEN);
+  CX_TEST_ASSERT(loader.Failures().size() == 2);
+
+  loader.Publish("numbers", numbers);
+  CX_TEST_ASSERT(loader.Load(g_sample).Ok());
+  CX_TEST_ASSERT(loader.Loaded() == 1);
+
+  std::unique_ptr<PluginBase> object(words.New("hello", "world"));
+  CX_TEST_ASSERT(object && (object->Text() == "hello, world"));
+  object.reset(numbers.New(7, "dwarves"));
+  CX_TEST_ASSERT(object && (object->Text() == "seven dwarves"));
+  CX_TEST_ASSERT(!words.New("goodbye", "world"));
+CX_ENDFUNCTION
+
+
+CX_FUNCTION(void Test_LAZY)
+  printf("Testing lazy loading...\n");
+
+  char dir[] = "/tmp/cx-plugin-XXXXXX";
+  CX_TEST_ASSERT(mkdtemp(dir));
+  std::string base(dir);
+
+  // one plugin with a manifest; one that won't load; and one whose
+  // manifest is malformed
+  CX_TEST_ASSERT(!symlink(g_sample, (base + "/sample.so").c_str()));
+  _write(base + "/sample.cxplugin",
+         "# what pluginsample defines\n"
+         "words  hello\n"
+         "numbers 7   # the only number\n");
+  _write(base + "/broken.so", "not a shared object\n");
+  CX_TEST_ASSERT(!symlink(g_sample, (base + "/malformed.so").c_str()));
+  _write(base + "/malformed.cxplugin", "words\n");
+  _write(base + "/ignored.txt", "\n");
+
+  WordFactory words;
+  NumberFactory numbers;
+  CX::PluginLoader loader;    // which they outlive
+  loader.Publish("words", words);
+  loader.Publish("numbers", numbers);
+
+  CX::PluginCount found = loader.Scan(dir);
+  CX_TEST_ASSERT(found.Ok() && (found.Value() == 3));
+  CX_TEST_ASSERT(loader.Loaded() == 0);
+  CX_TEST_ASSERT(loader.Deferred() == 1);
+  CX_TEST_ASSERT(loader.Failures().size() == 2);
+  CX_TEST_ASSERT(!words.Contains("hello"));
+
+  // a key nobody claims doesn't load anything, however often it
+  // misses; nor does a plain Factory's miss, even of a claimed key
+  CX_TEST_ASSERT(!numbers.New(8, "ball"));
+  CX_TEST_ASSERT(!numbers.New(8, "ball"));
+  CX_TEST_ASSERT(!words.New("hello", "world"));
+  CX_TEST_ASSERT(loader.Loaded() == 0);
+
+  std::unique_ptr<PluginBase> object(numbers.New(7, "samurai"));
+  CX_TEST_ASSERT(object && (object->Text() == "seven samurai"));
+  CX_TEST_ASSERT((loader.Loaded() == 1) && (loader.Deferred() == 0));
+  object.reset(words.New("hello", "again"));
+  CX_TEST_ASSERT(object && (object->Text() == "hello, again"));
+
+  CX_TEST_ASSERT(!loader.Scan("/nonexistent").Ok());
+
+  // and the factories outlive the loader, which unhooks them
+  {
+    CX::PluginLoader shortlived;
+    shortlived.Publish("numbers", numbers);
+  }
+  CX_TEST_ASSERT(!numbers.New(8, "ball"));
+
+  for (char const* name : { "sample.so", "sample.cxplugin", "broken.so",
+                            "malformed.so", "malformed.cxplugin",
+                            "ignored.txt" })
+    unlink((base + "/" + name).c_str());
+  rmdir(dir);
+CX_ENDFUNCTION
+
+
+int main(int argc, char** argv)
+{
+  char const* sample = getenv("CX_PLUGINSAMPLE");
+  CX_TEST_ASSERT(sample && realpath(sample, g_sample));
+
+  Test_LOAD();
+  Test_LAZY();
+
+  exit(EXIT_SUCCESS);
+}
@@ -0,0 +1,30 @@
+// vim: set tabstop=2 softtabstop=2 shiftwidth=2 expandtab :
+/*
+ * Copyright (c) 2026, Ryan V. Bissell
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ * See the enclosed "LICENSE" file for exact license terms.
+ */
+
+#ifndef CX_TEST_PLUGIN_HPP
+#define CX_TEST_PLUGIN_HPP
+
+// shared by plugin.cpp and the plugin it loads, pluginsample.cpp
+
+#include "cx-factory.hpp"
+
+#include <string>
+
+class PluginBase
+{
+  public:
+    virtual ~PluginBase() {}
+    virtual std::string Text() = 0;
+};
+
+typedef CX::Factory<PluginBase, std::string, std::string> WordFactory;
+typedef CX::ConcurrentFactory<PluginBase, uint32_t, std::string>
+  NumberFactory;
+
+#endif  // CX_TEST_PLUGIN_HPP
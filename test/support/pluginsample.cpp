@@ -0,0 +1,54 @@
+// vim: set tabstop=2 softtabstop=2 shiftwidth=2 expandtab :
+/*
+ * Copyright (c) 2026, Ryan V. Bissell
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ * See the enclosed "LICENSE" file for exact license terms.
+ */
+
+// a plugin (built as a shared object) for plugin.cpp to load
+
+#include "cx-plugin.hpp"
+#include "plugin.hpp"
+
+#include <memory>
+
+
+class HelloClass: public PluginBase
+{
+  public:
+    HelloClass(const std::string& text): text_(text) {}
+    std::string Text() { return "hello, " + text_; }
+
+  private:
+    std::string text_;
+};
+
+class SevenClass: public PluginBase
+{
+  public:
+    SevenClass(const std::string& text): text_(text) {}
+    std::string Text() { return "seven " + text_; }
+
+  private:
+    std::string text_;
+};
+
+
+CX_PLUGIN_ENTRY(host)
+{
+  auto words = host.Find<WordFactory>("words");
+  auto numbers = host.Find<NumberFactory>("numbers");
+  if (!words || !numbers || !host.Path())
+    return false;
+
+  // a key of our own, that may be why we're loading; which mustn't
+  // load us again
+  if (std::unique_ptr<PluginBase>(numbers->New(7, "")))
+    return false;
+
+  words->Define<HelloClass>("hello");
+  numbers->Define<SevenClass>(7);
+  return true;
+}
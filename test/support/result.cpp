@@ -0,0 +1,122 @@
+// vim: set tabstop=2 softtabstop=2 shiftwidth=2 expandtab :
+/*
+ * Copyright (c) 2026, Ryan V. Bissell
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ * See the enclosed "LICENSE" file for exact license terms.
+ */
+
+#include "cx-test-support.hpp"
+#include "cx-result.hpp"
+
+#include <memory>
+#include <string>
+
+
+CX_FUNCTION(CX::Result<int> parse_digit, char c)
+  if ((c < '0') || (c > '9'))
+    CX_FAIL(CX::Exception, CX::Error::NONE, "'%c' is not a digit", c);
+  CX_RETURN(c - '0');
+CX_ENDFUNCTION
+
+
+CX_FUNCTION(CX::Result<int> parse_number, char const* text)
+  int number = 0;
+  for (; *text; ++text)
+  {
+    CX_UNWRAP(int digit, parse_digit(*text));
+    number = number * 10 + digit;
+  }
+  CX_RETURN(number);
+CX_ENDFUNCTION
+
+
+CX_FUNCTION(CX::Result<void> check_number, char const* text)
+  CX_PROPAGATE(parse_number(text));
+  CX_RETURN(CX::Result<void>());
+CX_ENDFUNCTION
+
+
+CX_FUNCTION(CX::Result<std::unique_ptr<std::string>> make_text,
+            char const* text)
+  if (!text)
+    CX_FAIL(CX::Exception, CX::Error::NONE, "no text");
+  CX_RETURN(std::make_unique<std::string>(text));
+CX_ENDFUNCTION
+
+
+CX_FUNCTION(void Test_VALUES)
+  printf("Testing successful Results...\n");
+
+  CX::Result<int> number = parse_number("1234");
+  CX_TEST_ASSERT(number.Ok());
+  CX_TEST_ASSERT(number.Value() == 1234);
+  CX_TEST_ASSERT(check_number("42").Ok());
+
+  // move-only values
+  auto text = make_text("hello").ValueOrThrow();
+  CX_TEST_ASSERT(*text == "hello");
+CX_ENDFUNCTION
+
+
+CX_FUNCTION(void Test_FAILURES)
+  printf("Testing failed Results...\n");
+
+  CX::Result<int> number = parse_number("12x4");
+  CX_TEST_ASSERT(!number);
+  CX_TEST_ASSERT(!strcmp(number.Error().Reason(), "'x' is not a digit"));
+  CX_TEST_ASSERT(!strcmp(number.Error().Name(), "CXError::NONE"));
+  CX_TEST_ASSERT(!strncmp(number.Error().Where(), "result.cpp:", 11));
+
+  CX::Result<void> checked = check_number("9-");
+  CX_TEST_ASSERT(!checked.Ok());
+  CX_TEST_ASSERT(!strcmp(checked.Error().Reason(), "'-' is not a digit"));
+CX_ENDFUNCTION
+
+
+CX_FUNCTION(void Test_THROW)
+  printf("Testing Results thrown at API boundaries...\n");
+
+  bool caught = false;
+  CX_TRY
+    make_text(nullptr).ValueOrThrow();
+  CX_CATCH(CX::Exception& e)
+    caught = true;
+    CX_TEST_ASSERT(!strcmp(e.Reason(), "no text"));
+  CX_ENDTRY
+  CX_TEST_ASSERT(caught);
+CX_ENDFUNCTION
+
+
+#ifdef CX_OPT_THROWSTACK
+CX_FUNCTION(void Test_STACK)
+  printf("Testing that only thrown Results capture a stack...\n");
+
+  CX::Result<int> number = parse_number("12x4");
+  CX_TEST_ASSERT(!number);
+  CX_TEST_ASSERT(number.Error().StackDepth() == 0);
+
+  bool caught = false;
+  CX_TRY
+    number.Throw();
+  CX_CATCH(CX::Exception& e)
+    caught = true;
+    CX_TEST_ASSERT(e.StackDepth() > 1);
+  CX_ENDTRY
+  CX_TEST_ASSERT(caught);
+CX_ENDFUNCTION
+#endif
+
+
+int main(int argc, char** argv)
+{
+  Test_VALUES();
+  Test_FAILURES();
+  Test_THROW();
+#ifdef CX_OPT_THROWSTACK
+  Test_STACK();
+#endif
+
+  exit(EXIT_SUCCESS);
+}
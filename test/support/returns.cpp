@@ -0,0 +1,149 @@
+// vim: set tabstop=2 softtabstop=2 shiftwidth=2 expandtab :
+/*
+ * Copyright (c) 2026, Ryan V. Bissell
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ * See the enclosed "LICENSE" file for exact license terms.
+ */
+
+#define CX_TRACE_SECTION "returns"
+
+#include "cx-test-support.hpp"
+#include "cx-tracedebug.hpp"
+#include "cx-exceptions.hpp"
+
+#include <memory>
+#include <string>
+
+
+// neither copyable nor movable; only guaranteed elision can return it
+class Pinned
+{
+  public:
+    explicit Pinned(int value) : value_(value) {}
+    Pinned(Pinned const&) = delete;
+    Pinned(Pinned&&) = delete;
+
+    int value_;
+};
+
+
+class Counted
+{
+  public:
+    explicit Counted(int value) : value_(value) {}
+    Counted(Counted const& other) : value_(other.value_) { ++copies; }
+    Counted(Counted&& other) : value_(other.value_) { ++moves; }
+
+    int value_;
+    static int copies;
+    static int moves;
+};
+
+int Counted::copies = 0;
+int Counted::moves = 0;
+
+
+class Holder
+{
+  public:
+    Holder() : text_("held") {}
+    std::string const& Text() const;
+
+  private:
+    std::string text_;
+};
+
+
+CX_FUNCTION(Pinned make_pinned, int value)
+  CX_RETURN(Pinned(value));
+CX_ENDFUNCTION
+
+
+CX_FUNCTION(std::unique_ptr<int> make_unique, int value)
+  std::unique_ptr<int> result(new int(value));
+  CX_RETURN(result);
+CX_ENDFUNCTION
+
+
+CX_FUNCTION(Counted make_counted, bool named)
+  if (!named)
+    CX_RETURN(Counted(1));
+
+  Counted result(2);
+  CX_RETURN(result);
+CX_ENDFUNCTION
+
+
+CX_CONSTMETHOD(std::string const& Holder::Text)
+  CX_RETURNREF(text_);
+CX_ENDMETHOD
+
+
+CX_FUNCTION(void nothing)
+  CX_RETURNVOID;
+CX_ENDFUNCTION
+
+
+CX_FUNCTION(void thrower)
+  CX_THROW(CX::Exception, CX::Error::NONE, "%s", "unwinding");
+CX_ENDFUNCTION
+
+
+CX_FUNCTION(void Test_ELISION)
+
+  printf("Testing CX_RETURN of non-movable and move-only types...\n");
+  CX_TEST_ASSERT(make_pinned(42).value_ == 42);
+  CX_TEST_ASSERT(*make_unique(7) == 7);
+
+  printf("Testing that CX_RETURN doesn't copy...\n");
+  Counted a = make_counted(false);
+  Counted b = make_counted(true);
+  CX_TEST_ASSERT((a.value_ == 1) && (b.value_ == 2));
+  CX_TEST_ASSERT(Counted::copies == 0);
+  CX_TEST_ASSERT(Counted::moves <= 1);  // NRVO is not guaranteed
+
+  printf("Testing CX_RETURNREF...\n");
+  Holder holder;
+  CX_TEST_ASSERT(&holder.Text() == &holder.Text());
+  CX_TEST_ASSERT(holder.Text() == "held");
+
+CX_ENDFUNCTION
+
+
+CX_FUNCTION(void Test_BALANCE)
+
+#if CX_OPT_TRACING
+  printf("Testing that trace levels stay balanced...\n");
+  U64 level = CX::get_tracelevel();
+
+  nothing();
+  make_counted(true);
+  CX_TEST_ASSERT(CX::get_tracelevel() == level);
+
+  CX_TRY
+  {
+    thrower();
+  }
+  CX_CATCH(const CX::Exception& e)
+  {
+    CX_TEST_ASSERT(CX::get_tracelevel() == level);
+  }
+  CX_ENDTRY
+#endif
+
+CX_ENDFUNCTION
+
+
+int main(int argc, char** argv)
+{
+  // trace everything, but keep it out of the test's output
+  setenv("CX_TRACE", "*", 1);
+  CX::set_debugfile(fopen("/dev/null", "w"));
+
+  Test_ELISION();
+  Test_BALANCE();
+
+  exit(EXIT_SUCCESS);
+}
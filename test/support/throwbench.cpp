@@ -0,0 +1,235 @@
+// vim: set tabstop=2 softtabstop=2 shiftwidth=2 expandtab :
+
+/*
+ * Copyright (c) 2026, Ryan V. Bissell
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ * See the enclosed "LICENSE" file for exact license terms.
+ */
+
+// Measures what a CX_THROW costs, from the throw to where it is
+// handled, a few frames up.  Built normally, that is a C++ throw
+// caught by CX_CATCH ('THROW'), next to a plain throw and catch of
+// the same exception type ('RAWTHROW'); built with
+// CX_OPT_NOEXCEPTIONS (and -fno-exceptions), it is the throw
+// handler longjmp'ing back.  Either way, throwing must not
+// allocate (beyond the ABI's own exception buffer.)
+//
+// Environment:
+//   CX_BENCHMS         minimum milliseconds per measurement (20)
+
+#define CX_TRACE_SECTION "bench"
+
+#include "cx-test-support.hpp"
+#include "cx-exceptions.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <new>
+
+#ifdef CX_OPT_NOEXCEPTIONS
+#include <setjmp.h>
+#define THROWBENCH_FLAVOR "noexceptions"
+#else
+#define THROWBENCH_FLAVOR "exceptions"
+#endif
+
+
+enum { DEPTH = 4 };
+
+static double g_minimum_ns;
+static std::atomic<U64> g_allocations(0);
+
+
+void* operator new(size_t size)
+{
+  g_allocations.fetch_add(1, std::memory_order_relaxed);
+  void* memory = malloc(size ? size : 1);
+  if (!memory)
+    abort();
+  return memory;
+}
+
+void operator delete(void* memory) noexcept
+{
+  free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept
+{
+  free(memory);
+}
+
+
+// out-of-line, so that the frames between throw and handler are real
+[[noreturn]] void bench_thrower(int depth, U64 i)
+  __attribute__((noinline));
+
+CX_FUNCTION(void bench_thrower, int depth, U64 i)
+  if (depth > 0)
+    bench_thrower(depth - 1, i);
+  else
+    CX_THROW(CX::Exception, CX::Error::NONE, "throw #%lu", i);
+  asm volatile("" ::: "memory");
+CX_ENDFUNCTION
+
+
+#ifdef CX_OPT_NOEXCEPTIONS
+static jmp_buf g_handled;
+static bool g_keepreason;
+static char g_handledreason[64];
+static char const* g_handledwhere;
+
+// the exception lives in the frame that threw it, which longjmp()
+// abandons; so whatever is wanted from it must be taken here.
+// (and since its destructor never runs, Reason() would leak.)
+static void _longjmp_handler(CX::BaseException const& exception)
+{
+  if (g_keepreason)
+  {
+    snprintf(g_handledreason, sizeof(g_handledreason), "%s",
+             exception.Reason());
+    g_keepreason = false;
+  }
+  g_handledwhere = exception.Where();
+  longjmp(g_handled, 1);
+}
+
+
+CX_FUNCTION(U64 bench_throws, U64 iterations)
+  static volatile U64 handled;
+  static volatile U64 i;
+
+  handled = 0;
+  for (i = 0; i < iterations; i = i + 1)
+  {
+    if (setjmp(g_handled) == 0)
+      bench_thrower(DEPTH, i);
+    else
+      handled = handled + 1;
+  }
+  CX_RETURN(handled);
+CX_ENDFUNCTION
+
+#else
+
+void bench_raw_thrower(int depth, U64 i) __attribute__((noinline));
+
+void bench_raw_thrower(int depth, U64 i)
+{
+  if (depth > 0)
+    bench_raw_thrower(depth - 1, i);
+  else
+    throw CX::Exception("bench_raw_thrower", "throwbench.cpp",
+                        CX::Error::NONE, "throw #%lu", i);
+  asm volatile("" ::: "memory");
+}
+
+
+static U64 bench_raw_throws(U64 iterations)
+{
+  U64 handled = 0;
+  for (U64 i = 0; i < iterations; ++i)
+  {
+    try {
+      bench_raw_thrower(DEPTH, i);
+    } catch (CX::Exception&) {
+      ++handled;
+    }
+  }
+  return handled;
+}
+
+
+CX_FUNCTION(U64 bench_throws, U64 iterations)
+  U64 handled = 0;
+  for (U64 i = 0; i < iterations; ++i)
+  {
+    CX_TRY
+      bench_thrower(DEPTH, i);
+    CX_CATCH(CX::Exception&)
+      ++handled;
+    CX_ENDTRY
+  }
+  CX_RETURN(handled);
+CX_ENDFUNCTION
+#endif
+
+
+CX_FUNCTION(void Test_HANDLED)
+  printf("Testing that every throw is handled (%s)...\n",
+         THROWBENCH_FLAVOR);
+
+#ifdef CX_OPT_NOEXCEPTIONS
+  CX::ThrowHandler previous = CX::set_throw_handler(_longjmp_handler);
+  CX_TEST_ASSERT(previous != nullptr);
+
+  g_keepreason = true;
+  if (setjmp(g_handled) == 0)
+  {
+    bench_thrower(DEPTH, 42);
+    CX_TEST_ASSERT(!"throw handler returned");
+  }
+  CX_TEST_ASSERT(!strcmp(g_handledreason, "throw #42"));
+  CX_TEST_ASSERT(!strncmp(g_handledwhere, "throwbench.cpp:", 15));
+
+  // and CX_TRY/CX_CATCH still compile, to something harmless
+  bool tried = false;
+  CX_TRY
+    tried = true;
+  CX_CATCH(CX::Exception const& e)
+    CX_TEST_ASSERT(!"nothing can be caught");
+  CX_ENDTRY
+  CX_TEST_ASSERT(tried);
+#endif
+
+  U64 allocations = g_allocations.load();
+  CX_TEST_ASSERT(bench_throws(100) == 100);
+  CX_TEST_ASSERT(g_allocations.load() == allocations);
+#ifndef CX_OPT_NOEXCEPTIONS
+  CX_TEST_ASSERT(bench_raw_throws(100) == 100);
+  CX_TEST_ASSERT(g_allocations.load() == allocations);
+#endif
+CX_ENDFUNCTION
+
+
+static void
+_measure(char const* name, U64 (*throws)(U64))
+{
+  U64 iterations = 100;
+  double ns;
+
+  // grow the batch until one measurement is long enough to trust
+  for (;;)
+  {
+    auto start = std::chrono::steady_clock::now();
+    CX_TEST_ASSERT(throws(iterations) == iterations);
+    auto stop = std::chrono::steady_clock::now();
+
+    std::chrono::duration<double, std::nano> elapsed = stop - start;
+    ns = elapsed.count() / iterations;
+    if ((elapsed.count() >= g_minimum_ns) || (iterations >= (1U << 24)))
+      break;
+    iterations *= 4;
+  }
+
+  // stdout may well be the trace file, so report on stderr
+  fprintf(stderr, "%s,%s,%d,%lu,%.2f\n",
+          THROWBENCH_FLAVOR, name, DEPTH, iterations, ns);
+}
+
+
+int main(int argc, char** argv)
+{
+  char const* ms = getenv("CX_BENCHMS");
+  g_minimum_ns = 1e6 * atof((ms && *ms) ? ms : "20");
+
+  Test_HANDLED();
+  _measure("THROW", bench_throws);
+#ifndef CX_OPT_NOEXCEPTIONS
+  _measure("RAWTHROW", bench_raw_throws);
+#endif
+
+  exit(EXIT_SUCCESS);
+}
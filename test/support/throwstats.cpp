@@ -0,0 +1,136 @@
+// vim: set tabstop=2 softtabstop=2 shiftwidth=2 expandtab :
+/*
+ * Copyright (c) 2026, Ryan V. Bissell
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ * See the enclosed "LICENSE" file for exact license terms.
+ */
+
+#include "cx-test-support.hpp"
+#include "cx-exceptions.hpp"
+
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+CX_FUNCTION(void throw_often, int i)
+  CX_THROW(CX::Exception, CX::Error::NONE, "often %d", i);
+CX_ENDFUNCTION
+
+
+CX_FUNCTION(void throw_rarely, int i)
+  CX_THROW(CX::Exception, CX::Error::NONE, "rarely %d", i);
+CX_ENDFUNCTION
+
+
+CX_FUNCTION(void throw_some, int often, int rarely)
+  for (int i = 0; i < often + rarely; ++i)
+  {
+    CX_TRY
+      if (i < often)
+        throw_often(i);
+      else
+        throw_rarely(i);
+    CX_CATCH(CX::Exception&)
+    CX_ENDTRY
+  }
+CX_ENDFUNCTION
+
+
+static CX::ThrowStats::Site const*
+_find_site(char const* method)
+{
+  for (auto site = CX::ThrowStats::get_sites(); site; site = site->next)
+    if (strstr(site->method, method))
+      return site;
+  return nullptr;
+}
+
+
+CX_FUNCTION(void Test_COUNTS)
+  printf("Testing per-site throw counts...\n");
+
+  CX_TEST_ASSERT(CX::ThrowStats::get_sites() == nullptr);
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t)
+    threads.emplace_back(throw_some, 100, 10);
+  for (auto& thread : threads)
+    thread.join();
+
+  auto often = _find_site("throw_often");
+  auto rarely = _find_site("throw_rarely");
+  CX_TEST_ASSERT(often && rarely);
+  CX_TEST_ASSERT(CX::ThrowStats::get_count(*often) == 400);
+  CX_TEST_ASSERT(CX::ThrowStats::get_count(*rarely) == 40);
+
+  CX_TEST_ASSERT(!strncmp(often->where, "throwstats.cpp:", 15));
+  CX_TEST_ASSERT(!strcmp(often->type, "CX::Exception"));
+  CX_TEST_ASSERT(!strcmp(often->what, "CX::Error::NONE"));
+
+  CX::ThrowStats::reset();
+  CX_TEST_ASSERT(CX::ThrowStats::get_count(*often) == 0);
+  throw_some(1, 0);
+  CX_TEST_ASSERT(CX::ThrowStats::get_count(*often) == 1);
+CX_ENDFUNCTION
+
+
+CX_FUNCTION(void Test_REPORT)
+  printf("Testing the throw report...\n");
+
+  CX::ThrowStats::reset();
+  throw_some(3, 5);
+
+  FILE* file = tmpfile();
+  CX::ThrowStats::report(file);
+  rewind(file);
+
+  std::vector<std::string> lines;
+  char line[512];
+  while (fgets(line, sizeof(line), file))
+    lines.push_back(line);
+  fclose(file);
+
+  // a header, then the most frequent site first
+  CX_TEST_ASSERT(lines.size() == 3);
+  CX_TEST_ASSERT(lines[1].find("throw_rarely") != std::string::npos);
+  CX_TEST_ASSERT(lines[2].find("throw_often") != std::string::npos);
+  CX_TEST_ASSERT(atoi(lines[1].c_str()) == 5);
+CX_ENDFUNCTION
+
+
+CX_FUNCTION(void Test_COST)
+  printf("Testing what counting costs...\n");
+
+  static CX::ThrowStats::Site site = { "here", "there", "type", "what" };
+  CX::ThrowStats::count(site);
+
+  U64 const iterations = 10000000;
+  auto start = std::chrono::steady_clock::now();
+  for (U64 i = 0; i < iterations; ++i)
+  {
+    CX::ThrowStats::count(site);
+    asm volatile("" ::: "memory");
+  }
+  auto stop = std::chrono::steady_clock::now();
+  std::chrono::duration<double, std::nano> elapsed = stop - start;
+
+  // a throw costs microseconds; this must stay in the nanoseconds
+  double ns = elapsed.count() / iterations;
+  fprintf(stderr, "ns per count: %.2f\n", ns);
+  CX_TEST_ASSERT(ns < 100.0);
+  CX_TEST_ASSERT(CX::ThrowStats::get_count(site) == iterations + 1);
+CX_ENDFUNCTION
+
+
+int main(int argc, char** argv)
+{
+  Test_COUNTS();
+  Test_REPORT();
+  Test_COST();
+
+  exit(EXIT_SUCCESS);
+}
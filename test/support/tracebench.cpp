@@ -0,0 +1,339 @@
+// vim: set tabstop=2 softtabstop=2 shiftwidth=2 expandtab :
+
+/*
+ * Copyright (c) 2026, Ryan V. Bissell
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ * See the enclosed "LICENSE" file for exact license terms.
+ */
+
+// Measures what the trace macros cost per call.  Which of the cases
+// ('out', 'disabled', 'devnull', 'file') is being measured depends
+// on how this was compiled and on the CX_* environment, so the
+// caller names it via CX_BENCHCASE.
+//
+// Each macro is measured on every thread count from 1 up, alongside
+// what it compiles to when it's compiled out (a plain call, or an
+// empty loop), on as many threads.  The baseline keeps the ratio of
+// the two, which doesn't depend (much) on the hardware the way that
+// nanoseconds do.  Thread counts the baseline lacks go unchecked.
+//
+// Environment:
+//   CX_BENCHCASE       label for this run (required)
+//   CX_BENCHTHREADS    highest thread count to try (default: ncpus)
+//   CX_BENCHMS         minimum milliseconds per measurement (20)
+//   CX_BENCHBASELINE   file of 'case macro threads ratio' lines
+//   CX_BENCHTOLERANCE  allowed slowdown vs. baseline (default 3.0)
+//   CX_BENCHUPDATE     if set, rewrite our lines in the baseline
+//   CX_BENCHRESULTS    if set, append CSV results to this file
+
+#define CX_TRACE_SECTION "bench"
+
+#include "cx-test-support.hpp"
+#include "cx-hackery.hpp"
+#include "cx-tracedebug.hpp"
+
+#include <chrono>
+#include <map>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+
+typedef std::tuple<std::string, std::string, unsigned> BenchKey;
+
+struct BenchResult
+{
+  std::string macro;
+  unsigned threads;
+  U64 iterations;
+  double ns;
+  double ratio;   // to the same, compiled out
+};
+
+
+static char const* g_case;
+static double g_minimum_ns;
+
+
+static char const*
+_getenv(char const* name, char const* fallback)
+{
+  char const* value = getenv(name);
+  return (value && *value) ? value : fallback;
+}
+
+
+// out-of-line, so that the compiled-out case still measures a call
+U64 bench_method(U64 n) __attribute__((noinline));
+
+CX_FUNCTION(U64 bench_method, U64 n)
+  CX_RETURN(n + 1);
+CX_ENDFUNCTION
+
+
+// bench_method(), as it is when tracing is compiled out
+U64 reference_method(U64 n) __attribute__((noinline));
+
+U64 reference_method(U64 n)
+{
+  return n + 1;
+}
+
+
+CX_FUNCTION(void bench_traceout, U64 iterations)
+  for (U64 i = 0; i < iterations; ++i)
+  {
+    CX_TRACEOUT("traceout %lu\n", i);
+    asm volatile("" ::: "memory");
+  }
+CX_ENDFUNCTION
+
+
+CX_FUNCTION(void bench_topicout, U64 iterations)
+  for (U64 i = 0; i < iterations; ++i)
+  {
+    CX_TOPICOUT(bench:topic, "topicout %lu\n", i);
+    asm volatile("" ::: "memory");
+  }
+CX_ENDFUNCTION
+
+
+CX_FUNCTION(void bench_debugout, U64 iterations)
+  for (U64 i = 0; i < iterations; ++i)
+  {
+    CX_DEBUGOUT("debugout %lu\n", i);
+    asm volatile("" ::: "memory");
+  }
+CX_ENDFUNCTION
+
+
+static void
+_run_method(U64 iterations)
+{
+  U64 n = 0;
+  for (U64 i = 0; i < iterations; ++i)
+    n = bench_method(n);
+  CX_TEST_ASSERT(n == iterations);
+}
+
+
+static void
+_run_reference_method(U64 iterations)
+{
+  U64 n = 0;
+  for (U64 i = 0; i < iterations; ++i)
+    n = reference_method(n);
+  CX_TEST_ASSERT(n == iterations);
+}
+
+
+// the other macros' loops, with the macros compiled out
+static void
+_run_reference_loop(U64 iterations)
+{
+  for (U64 i = 0; i < iterations; ++i)
+    asm volatile("" ::: "memory");
+}
+
+
+// runs 'body' on 'threads' threads at once, 'iterations' times
+// each, and returns the wall-clock nanoseconds per call seen by
+// any one thread.
+static double
+_time_threads(void (*body)(U64), unsigned threads, U64 iterations)
+{
+  std::vector<std::thread> pool;
+
+  auto start = std::chrono::steady_clock::now();
+  for (unsigned t = 1; t < threads; ++t)
+    pool.emplace_back(body, iterations);
+  body(iterations);
+  for (auto& thread : pool)
+    thread.join();
+  auto stop = std::chrono::steady_clock::now();
+
+  std::chrono::duration<double, std::nano> elapsed = stop - start;
+  return elapsed.count() / iterations;
+}
+
+
+// grows the batch until one measurement is long enough to trust;
+// returns ns per call, and sets 'iterations' to that batch
+static double
+_time_batch(void (*body)(U64), unsigned threads, U64& iterations)
+{
+  for (iterations = 1000; ; iterations *= 4)
+  {
+    double ns = _time_threads(body, threads, iterations);
+    if ((ns * iterations >= g_minimum_ns) ||
+        (iterations >= (U64(1) << 32)))
+      return ns;
+  }
+}
+
+
+static BenchResult
+_measure(char const* macro, void (*body)(U64), void (*reference)(U64),
+         unsigned threads)
+{
+  BenchResult result = { macro, threads, 0, 0.0, 0.0 };
+  result.ns = _time_batch(body, threads, result.iterations);
+
+  U64 iterations;
+  double floor = _time_batch(reference, threads, iterations);
+  result.ratio = result.ns / floor;
+
+  return result;
+}
+
+
+static std::map<BenchKey, double>
+_read_baseline(char const* path)
+{
+  std::map<BenchKey, double> baseline;
+
+  FILE* file = path ? fopen(path, "r") : nullptr;
+  if (!file)
+    return baseline;
+
+  char name[64], macro[64];
+  unsigned threads;
+  double ratio;
+  char line[256];
+  while (fgets(line, sizeof(line), file))
+  {
+    if (line[0] == '#')
+      continue;
+    if (sscanf(line, "%63s %63s %u %lf", name, macro, &threads,
+               &ratio) == 4)
+      baseline[BenchKey(name, macro, threads)] = ratio;
+  }
+  fclose(file);
+
+  return baseline;
+}
+
+
+static void
+_write_baseline(char const* path,
+                std::map<BenchKey, double> const& baseline)
+{
+  FILE* file = fopen(path, "w");
+  CX_TEST_ASSERT(file != nullptr);
+
+  fprintf(file, "# case macro threads ratio-to-compiled-out\n");
+  fprintf(file, "# regenerate with CX_BENCHUPDATE=1 (see tracebench.TF)\n");
+  for (auto const& entry : baseline)
+  {
+    fprintf(file, "%s %s %u %.2f\n",
+            std::get<0>(entry.first).c_str(),
+            std::get<1>(entry.first).c_str(),
+            std::get<2>(entry.first), entry.second);
+  }
+  fclose(file);
+}
+
+
+static void
+_write_results(std::vector<BenchResult> const& results)
+{
+  char const* path = _getenv("CX_BENCHRESULTS", nullptr);
+  FILE* file = path ? fopen(path, "a") : nullptr;
+
+  // stdout may well be the trace file, so report on stderr
+  for (auto const& result : results)
+  {
+    fprintf(stderr, "%s,%s,%u,%lu,%.2f,%.2f\n",
+            g_case, result.macro.c_str(), result.threads,
+            result.iterations, result.ns, result.ratio);
+    if (file)
+      fprintf(file, "%s,%s,%u,%lu,%.2f,%.2f\n",
+              g_case, result.macro.c_str(), result.threads,
+              result.iterations, result.ns, result.ratio);
+  }
+
+  if (file)
+    fclose(file);
+}
+
+
+static bool
+_check_baseline(std::vector<BenchResult> const& results)
+{
+  char const* path = _getenv("CX_BENCHBASELINE", nullptr);
+  double tolerance = atof(_getenv("CX_BENCHTOLERANCE", "3.0"));
+  std::map<BenchKey, double> baseline = _read_baseline(path);
+
+  if (getenv("CX_BENCHUPDATE"))
+  {
+    CX_TEST_ASSERT(path != nullptr);
+    for (auto const& result : results)
+      baseline[BenchKey(g_case, result.macro, result.threads)] =
+        result.ratio;
+    _write_baseline(path, baseline);
+    return true;
+  }
+
+  bool passed = true;
+  for (auto const& result : results)
+  {
+    auto found = baseline.find(BenchKey(g_case, result.macro,
+                                        result.threads));
+    if (found == baseline.end())
+      continue;   // nothing recorded for this case/thread count
+
+    double limit = found->second * tolerance;
+    if (result.ratio > limit)
+    {
+      fprintf(stderr, "REGRESSION: %s %s x%u: %.2fx compiled out "
+                      "(baseline %.2fx, limit %.2fx)\n",
+              g_case, result.macro.c_str(), result.threads,
+              result.ratio, found->second, limit);
+      passed = false;
+    }
+  }
+
+  return passed;
+}
+
+
+int main(int argc, char** argv)
+{
+  g_case = _getenv("CX_BENCHCASE", nullptr);
+  CX_TEST_ASSERT(g_case != nullptr);
+
+  g_minimum_ns = 1e6 * atof(_getenv("CX_BENCHMS", "20"));
+
+  unsigned maxthreads = std::thread::hardware_concurrency();
+  maxthreads = atoi(_getenv("CX_BENCHTHREADS",
+                            std::to_string(maxthreads).c_str()));
+  maxthreads = CX_MAX(1U, maxthreads);
+
+  // the trace library initializes itself lazily, and not in a
+  // thread-safe manner; so get that done before going wide.
+  _run_method(1);
+  bench_traceout(1);
+  bench_topicout(1);
+  bench_debugout(1);
+
+  std::vector<BenchResult> results;
+  for (unsigned threads = 1; threads <= maxthreads; ++threads)
+  {
+    results.push_back(_measure("METHOD", _run_method,
+                               _run_reference_method, threads));
+    results.push_back(_measure("TRACEOUT", bench_traceout,
+                               _run_reference_loop, threads));
+    results.push_back(_measure("TOPICOUT", bench_topicout,
+                               _run_reference_loop, threads));
+    results.push_back(_measure("DEBUGOUT", bench_debugout,
+                               _run_reference_loop, threads));
+  }
+
+  _write_results(results);
+  CX_TEST_ASSERT(_check_baseline(results));
+
+  exit(EXIT_SUCCESS);
+}
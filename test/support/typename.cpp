@@ -0,0 +1,66 @@
+// vim: set tabstop=2 softtabstop=2 shiftwidth=2 expandtab :
+/*
+ * Copyright (c) 2026, Ryan V. Bissell
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ * See the enclosed "LICENSE" file for exact license terms.
+ */
+
+#include "cx-test-support.hpp"
+#include "cx-tracedebug.hpp"
+
+#include <string.h>
+
+
+namespace Outer
+{
+  class Inner {};
+
+  template <typename T, int N>
+  struct Holder {};
+}
+
+
+#if defined(__clang__) || defined(__GNUG__)
+static_assert(CX::get_typename_view<int>() == "int");
+static_assert(CX::get_typename_view<Outer::Inner>() == "Outer::Inner");
+#endif
+
+
+void Test_VIEW()
+{
+  printf("Testing CX::get_typename_view()...\n");
+
+  CX_TEST_ASSERT(CX::get_typename_view<U8>() == "unsigned char");
+  CX_TEST_ASSERT(CX::get_typename_view<Outer::Inner*>() ==
+                 "Outer::Inner*");
+  CX_TEST_ASSERT((CX::get_typename_view<Outer::Holder<char, 3>>() ==
+                  "Outer::Holder<char, 3>"));
+  CX_TEST_ASSERT(CX::get_typename_view<int[4]>() == "int [4]");
+}
+
+
+void Test_CACHED()
+{
+  printf("Testing CX::get_typename()...\n");
+
+  std::string const& first = CX::get_typename<Outer::Inner>();
+  std::string const& again = CX::get_typename<Outer::Inner>();
+
+  CX_TEST_ASSERT(&first == &again);
+  CX_TEST_ASSERT(0 == strcmp(first.c_str(), "Outer::Inner"));
+
+  // the demangled RTTI name agrees, for anything unremarkable
+  // (it spells out defaulted template arguments, though.)
+  CX_TEST_ASSERT(CX::detail::demangle_typename<Outer::Inner>() == first);
+}
+
+
+int main(int argc, char** argv)
+{
+  Test_VIEW();
+  Test_CACHED();
+
+  exit(EXIT_SUCCESS);
+}
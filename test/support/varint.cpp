@@ -0,0 +1,289 @@
+// vim: set tabstop=2 softtabstop=2 shiftwidth=2 expandtab :
+/*
+ * Copyright (c) 2026, Ryan V. Bissell
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ * See the enclosed "LICENSE" file for exact license terms.
+ */
+
+#include "cx-test-support.hpp"
+#include "cx-varint.hpp"
+
+#include <string.h>
+
+#include <algorithm>
+#include <limits>
+#include <random>
+#include <vector>
+
+
+// as they're encoded, as constant expressions
+template <typename T, size_t SIZE>
+constexpr bool _encodes(T value, U8 const (&expect)[SIZE])
+{
+  U8 bytes[CX::Varint::MAXBYTES<T>] = {};
+  if (CX::Varint::encode(bytes, value) != SIZE)
+    return false;
+  for (size_t i = 0; i < SIZE; ++i)
+    if (bytes[i] != expect[i])
+      return false;
+
+  T decoded = 0;
+  return (CX::Varint::decode(decoded, bytes, SIZE) == SIZE) &&
+         (decoded == value) &&
+         (CX::Varint::encoded_size(value) == SIZE);
+}
+
+
+void Test_CONSTEXPR()
+{
+  printf("Testing encodings as they compile...\n");
+
+  static_assert(CX::Varint::MAXBYTES<U16> == 3, "");
+  static_assert(CX::Varint::MAXBYTES<U32> == 5, "");
+  static_assert(CX::Varint::MAXBYTES<S64> == 10, "");
+
+  static_assert(CX::Varint::zigzag<S32>(0) == 0, "");
+  static_assert(CX::Varint::zigzag<S32>(-1) == 1, "");
+  static_assert(CX::Varint::zigzag<S32>(1) == 2, "");
+  static_assert(CX::Varint::zigzag<S16>(-32768) == 0xffff, "");
+  static_assert(CX::Varint::unzigzag<S64>(3) == -2, "");
+
+  static_assert(_encodes<U32>(0, { 0x00 }), "");
+  static_assert(_encodes<U32>(127, { 0x7f }), "");
+  static_assert(_encodes<U32>(300, { 0xac, 0x02 }), "");
+  static_assert(_encodes<U16>(0xffff, { 0xff, 0xff, 0x03 }), "");
+  static_assert(_encodes<U32>(0xffffffff,
+                              { 0xff, 0xff, 0xff, 0xff, 0x0f }), "");
+  static_assert(_encodes<S32>(-1, { 0x01 }), "");
+  static_assert(_encodes<S32>(-65, { 0x81, 0x01 }), "");
+  static_assert(_encodes<U64>(~0ULL, { 0xff, 0xff, 0xff, 0xff, 0xff,
+                                       0xff, 0xff, 0xff, 0xff, 0x01 }),
+                "");
+}
+
+
+template <typename T>
+static void
+_round_trip()
+{
+  typedef std::numeric_limits<T> Limits;
+  typedef std::make_unsigned_t<T> U;
+  std::vector<T> values = { 0, 1, Limits::min(), Limits::max() };
+  for (unsigned bits = 1; bits < (sizeof(T) * 8); ++bits)
+  {
+    U const power = static_cast<U>(1ULL << bits);
+    values.push_back(static_cast<T>(power));
+    values.push_back(static_cast<T>(power - 1));
+    values.push_back(static_cast<T>(0 - power));
+  }
+
+  for (T value : values)
+  {
+    U8 bytes[CX::Varint::MAXBYTES<T> + 1];
+    memset(bytes, 0xaa, sizeof(bytes));
+    size_t size = CX::Varint::encode(bytes, value);
+    CX_TEST_ASSERT(size == CX::Varint::encoded_size(value));
+    CX_TEST_ASSERT(size <= CX::Varint::MAXBYTES<T>);
+    CX_TEST_ASSERT(bytes[size] == 0xaa);
+
+    T decoded = 0;
+    CX_TEST_ASSERT(CX::Varint::decode(decoded, bytes, size) == size);
+    CX_TEST_ASSERT(decoded == value);
+
+    // cut short
+    CX_TEST_ASSERT(CX::Varint::decode(decoded, bytes, size - 1) == 0);
+  }
+}
+
+
+void Test_ROUNDTRIP()
+{
+  printf("Testing single values...\n");
+
+  _round_trip<U16>();
+  _round_trip<S16>();
+  _round_trip<U32>();
+  _round_trip<S32>();
+  _round_trip<U64>();
+  _round_trip<S64>();
+}
+
+
+void Test_MALFORMED()
+{
+  printf("Testing malformed varints...\n");
+
+  U16 u16 = 0;
+  U32 u32 = 0;
+  U64 u64 = 0;
+
+  // redundant, but not too long
+  U8 const zero[] = { 0x80, 0x80, 0x00 };
+  CX_TEST_ASSERT(CX::Varint::decode(u16, zero, 3) == 3);
+  CX_TEST_ASSERT(u16 == 0);
+
+  // too long
+  U8 const runon[] = { 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+                       0x80, 0x80, 0x80, 0x80, 0x00 };
+  CX_TEST_ASSERT(CX::Varint::decode(u16, runon, 4) == 0);
+  CX_TEST_ASSERT(CX::Varint::decode(u32, runon, 6) == 0);
+  CX_TEST_ASSERT(CX::Varint::decode(u64, runon, 11) == 0);
+
+  // more bits than fit
+  U8 const wide16[] = { 0xff, 0xff, 0x04 };
+  CX_TEST_ASSERT(CX::Varint::decode(u16, wide16, 3) == 0);
+  U8 const wide32[] = { 0xff, 0xff, 0xff, 0xff, 0x10 };
+  CX_TEST_ASSERT(CX::Varint::decode(u32, wide32, 5) == 0);
+  U8 const wide64[] = { 0xff, 0xff, 0xff, 0xff, 0xff,
+                        0xff, 0xff, 0xff, 0xff, 0x02 };
+  CX_TEST_ASSERT(CX::Varint::decode(u64, wide64, 10) == 0);
+
+  // nothing at all
+  CX_TEST_ASSERT(CX::Varint::decode(u32, zero, 0) == 0);
+}
+
+
+// values of 1..MAXBYTES<T> bytes, mostly short, as the wire has them
+template <typename T>
+static std::vector<T>
+_values(size_t count, std::mt19937_64& random)
+{
+  typedef std::make_unsigned_t<T> U;
+  std::vector<T> values(count);
+  for (auto& value : values)
+  {
+    unsigned const bits = random() % (sizeof(T) * 8 + 1);
+    U chosen = static_cast<U>(random());
+    if (bits < (sizeof(T) * 8))
+      chosen &= static_cast<U>((U(1) << bits) - 1);
+    if ((random() % 4) == 0)
+      chosen &= 0x7f;
+    value = static_cast<T>(chosen);
+  }
+  return values;
+}
+
+
+template <typename T>
+static void
+_test_bulk(std::mt19937_64& random)
+{
+  for (size_t count : { 0, 1, 15, 16, 17, 100, 4000 })
+  {
+    std::vector<T> values = _values<T>(count, random);
+    std::vector<U8> bytes(count * CX::Varint::MAXBYTES<T>);
+    size_t size = CX::Varint::encode(bytes.data(), values.data(), count);
+
+    std::vector<T> decoded(count + 1);
+    CX::Varint::Decoded got = CX::Varint::decode(decoded.data(), count,
+                                                 bytes.data(), size);
+    CX_TEST_ASSERT(got.count == count);
+    CX_TEST_ASSERT(got.bytes == size);
+    CX_TEST_ASSERT(std::equal(values.begin(), values.end(),
+                              decoded.begin()));
+
+    // no more than asked for, even when there's more
+    if (count > 1)
+    {
+      got = CX::Varint::decode(decoded.data(), count - 1, bytes.data(),
+                               size);
+      CX_TEST_ASSERT(got.count == count - 1);
+      CX_TEST_ASSERT(got.bytes == size -
+                                    CX::Varint::encoded_size(values.back()));
+    }
+
+    // cut short, which stops short of the last
+    if (count)
+    {
+      got = CX::Varint::decode(decoded.data(), count, bytes.data(),
+                               size - 1);
+      CX_TEST_ASSERT(got.count == count - 1);
+    }
+  }
+
+  // stops at a malformed varint, wherever it is
+  for (size_t bad : { 0, 5, 16, 31, 200 })
+  {
+    std::vector<T> values = _values<T>(300, random);
+    std::vector<U8> bytes(300 * CX::Varint::MAXBYTES<T> + 16);
+    size_t before = CX::Varint::encode(bytes.data(), values.data(), bad);
+    size_t size = before;
+    for (size_t i = 0; i < CX::Varint::MAXBYTES<T>; ++i)
+      bytes[size++] = 0xff;
+    bytes[size++] = 0x01;
+    size += CX::Varint::encode(bytes.data() + size, values.data() + bad,
+                               values.size() - bad);
+
+    std::vector<T> decoded(values.size());
+    CX::Varint::Decoded got = CX::Varint::decode(decoded.data(),
+                                                 decoded.size(),
+                                                 bytes.data(), size);
+    CX_TEST_ASSERT(got.count == bad);
+    CX_TEST_ASSERT(got.bytes == before);
+    CX_TEST_ASSERT(std::equal(values.begin(), values.begin() + bad,
+                              decoded.begin()));
+  }
+}
+
+
+// every U16 takes at most three bytes, and those have room for more
+static void
+_test_bulk_overflow()
+{
+  std::vector<U8> bytes(64, 0x01);
+  U8 const over[] = { 0x80, 0x80, 0x04 };
+  memcpy(&bytes[3], over, sizeof(over));
+
+  std::vector<U16> decoded(bytes.size());
+  CX::Varint::Decoded got = CX::Varint::decode(decoded.data(),
+                                               decoded.size(),
+                                               bytes.data(), bytes.size());
+  CX_TEST_ASSERT(got.count == 3);
+  CX_TEST_ASSERT(got.bytes == 3);
+}
+
+
+void Test_BULK()
+{
+  CX::Endian::Kernel const best = CX::Varint::get_kernel();
+  std::mt19937_64 random(46);
+
+  for (auto kernel : { CX::Endian::Kernel::SCALAR,
+                       CX::Endian::Kernel::SSSE3 })
+  {
+    char const* name = CX::Endian::kernel_name(kernel);
+    if (!CX::Varint::set_kernel(kernel))
+    {
+      printf("Skipping the %s kernel; this CPU lacks it.\n", name);
+      CX_TEST_ASSERT(kernel != CX::Endian::Kernel::SCALAR);
+      continue;
+    }
+
+    printf("Testing the %s kernel...\n", name);
+    CX_TEST_ASSERT(CX::Varint::get_kernel() == kernel);
+    _test_bulk<U16>(random);
+    _test_bulk<S16>(random);
+    _test_bulk<U32>(random);
+    _test_bulk<S32>(random);
+    _test_bulk<U64>(random);
+    _test_bulk<S64>(random);
+    _test_bulk_overflow();
+  }
+
+  // there are no wider kernels
+  CX_TEST_ASSERT(!CX::Varint::set_kernel(CX::Endian::Kernel::AVX512));
+  CX_TEST_ASSERT(CX::Varint::set_kernel(best));
+}
+
+
+int main(int argc, char** argv)
+{
+  Test_CONSTEXPR();
+  Test_ROUNDTRIP();
+  Test_MALFORMED();
+  Test_BULK();
+
+  exit(EXIT_SUCCESS);
+}
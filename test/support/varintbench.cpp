@@ -0,0 +1,157 @@
+// vim: set tabstop=2 softtabstop=2 shiftwidth=2 expandtab :
+/*
+ * Copyright (c) 2026, Ryan V. Bissell
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ * See the enclosed "LICENSE" file for exact license terms.
+ */
+
+// Decoding throughput of each varint kernel the CPU has, for values
+// of each width, whose encodings are: all one byte ('TINY'); of one
+// or two bytes ('SHORT'); of one to four ('MIXED'); and of any length
+// ('ANY').  'LOOP' is the same done one decode() at a time, for
+// comparison.  Reported as GB/s (of varints), and millions of values
+// per second.
+//
+// Environment:
+//   CX_BENCHMS         minimum milliseconds per measurement (20)
+
+#include "cx-test-support.hpp"
+#include "cx-varint.hpp"
+
+#include <chrono>
+#include <random>
+#include <vector>
+
+
+static double g_minimum_ns;
+
+enum { VALUES = 1 << 16 };
+
+
+// runs 'body' until that takes long enough to trust, and returns
+// nanoseconds per call
+template<typename TBody>
+static double
+_time(TBody body)
+{
+  U64 iterations = 1;
+  for (;;)
+  {
+    auto start = std::chrono::steady_clock::now();
+    for (U64 i = 0; i < iterations; ++i)
+    {
+      body();
+      asm volatile("" ::: "memory");
+    }
+    auto stop = std::chrono::steady_clock::now();
+
+    std::chrono::duration<double, std::nano> elapsed = stop - start;
+    if ((elapsed.count() >= g_minimum_ns) || (iterations >= (1U << 24)))
+      return elapsed.count() / iterations;
+    iterations *= 2;
+  }
+}
+
+
+// VALUES of T, each of up to 'bits' bits; of which, a quarter are
+// of 'bits', and the rest evenly spread among the shorter lengths
+template <typename T>
+static std::vector<T>
+_values(unsigned bits)
+{
+  typedef std::make_unsigned_t<T> U;
+  std::mt19937_64 random(bits);
+
+  std::vector<T> values(VALUES);
+  for (auto& value : values)
+  {
+    unsigned const width = ((random() % 4) == 0) ?
+                             bits : (1 + (random() % bits));
+    U chosen = static_cast<U>(random());
+    if (width < (sizeof(T) * 8))
+      chosen &= static_cast<U>((U(1) << width) - 1);
+    value = static_cast<T>(chosen);
+  }
+  return values;
+}
+
+
+template <typename T>
+static void
+_bench(char const* name, char const* test, unsigned bits, bool loop)
+{
+  std::vector<T> values = _values<T>(bits);
+  std::vector<U8> bytes(VALUES * CX::Varint::MAXBYTES<T>);
+  size_t const size = CX::Varint::encode(bytes.data(), values.data(),
+                                         VALUES);
+  std::vector<T> out(VALUES);
+
+  double ns;
+  if (loop)
+  {
+    ns = _time([&]()
+               {
+                 size_t used = 0;
+                 for (auto& value : out)
+                   used += CX::Varint::decode(value, bytes.data() + used,
+                                              size - used);
+                 CX_TEST_ASSERT(used == size);
+               });
+  }
+  else
+  {
+    ns = _time([&]()
+               {
+                 CX::Varint::Decoded decoded =
+                   CX::Varint::decode(out.data(), VALUES, bytes.data(),
+                                      size);
+                 CX_TEST_ASSERT(decoded.count == VALUES);
+               });
+  }
+  CX_TEST_ASSERT(out == values);
+
+  fprintf(stderr, "varint,%s,%zu,%s,%.2f,%.0f\n", name, sizeof(T) * 8,
+          test, size / ns, (VALUES * 1e3) / ns);
+}
+
+
+template <typename T>
+static void
+_bench_tests(char const* name, bool loop = false)
+{
+  _bench<T>(name, "TINY", 7, loop);
+  _bench<T>(name, "SHORT", 14, loop);
+  if (sizeof(T) > 2)
+    _bench<T>(name, "MIXED", 28, loop);
+  _bench<T>(name, "ANY", sizeof(T) * 8, loop);
+}
+
+
+int main(int argc, char** argv)
+{
+  char const* ms = getenv("CX_BENCHMS");
+  g_minimum_ns = 1e6 * atof((ms && *ms) ? ms : "20");
+
+  CX::Endian::Kernel const best = CX::Varint::get_kernel();
+
+  _bench_tests<U16>("LOOP", true);
+  _bench_tests<U32>("LOOP", true);
+  _bench_tests<U64>("LOOP", true);
+
+  for (auto kernel : { CX::Endian::Kernel::SCALAR,
+                       CX::Endian::Kernel::SSSE3 })
+  {
+    if (!CX::Varint::set_kernel(kernel))
+      continue;
+
+    char const* name = CX::Endian::kernel_name(kernel);
+    _bench_tests<U16>(name);
+    _bench_tests<U32>(name);
+    _bench_tests<U64>(name);
+  }
+
+  CX_TEST_ASSERT(CX::Varint::set_kernel(best));
+  exit(EXIT_SUCCESS);
+}